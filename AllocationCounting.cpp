@@ -0,0 +1,38 @@
+/**
+ * Heap allocation counting for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <new>
+#include <stdlib.h>
+
+#include "MemoryCounters.h"
+
+using namespace std;
+
+/**
+ * Replacement global allocation functions that count every allocation
+ * in the calling thread's MemoryCounters. They're for the simple
+ * driver only: a host that embeds the interpreter leaves this file
+ * out and keeps its own allocator.
+ */
+void *operator new(size_t size)
+{
+    MemoryCounters &counters = MemoryCounters::forThread();
+    counters.allocations++;
+    counters.bytes += size;
+
+    void *p = malloc(size != 0 ? size : 1);
+    if (p == nullptr) throw bad_alloc();
+
+    return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept           { free(p); }
+void operator delete[](void *p) noexcept         { free(p); }
+void operator delete(void *p, size_t) noexcept   { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
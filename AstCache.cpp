@@ -0,0 +1,43 @@
+/**
+ * Parse tree cache for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+
+#include "Hash.h"
+#include "AstCache.h"
+
+using namespace std;
+
+// The hash of the source that's stored in an entry to confirm a hit.
+// It has a different starting value from the hash in the file name,
+// so two sources would have to collide in both.
+static const uint64_t CHECK_BASIS = 0xbb67ae8584caa73bULL;
+
+AstCache::Mapping *AstCache::lookup(string_view source)
+{
+    string path = entries.entryPath(source, ".ast");
+    Mapping *mapping = new Mapping(path);
+
+    if (   !mapping->isValid()
+        || !mapping->getTree()->isFrom(source, hash64(source, CHECK_BASIS)))
+    {
+        delete mapping;
+        return nullptr;
+    }
+
+    entries.touch(path);
+    return mapping;
+}
+
+void AstCache::store(string_view source, Node *root,
+                     const vector<string> &slotNames)
+{
+    string image = FlatTree::flatten(root, slotNames, source,
+                                     hash64(source, CHECK_BASIS));
+
+    entries.store(entries.entryPath(source, ".ast"), { image });
+}
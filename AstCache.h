@@ -0,0 +1,81 @@
+/**
+ * Parse tree cache for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef ASTCACHE_H_
+#define ASTCACHE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+#include "intermediate/Node.h"
+#include "intermediate/FlatTree.h"
+#include "CacheDirectory.h"
+#include "MappedFile.h"
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * An on-disk cache of compiled parse trees in the flat format, keyed
+ * by a hash of the source. A hit memory-maps the cached tree and
+ * executes it in place: there's no scanning, no parsing, and no
+ * deserialization. Since a cache file can be damaged, the mapped tree
+ * is first checked in full, which reads every page of it once: the
+ * checksum and a walk over the nodes cost a pass over the file, which
+ * is still far cheaper than compiling the source again.
+ */
+class AstCache
+{
+public:
+    /**
+     * A cached tree, mapped into memory for as long as this exists.
+     */
+    class Mapping
+    {
+    public:
+        Mapping(const string &path)
+            : file(path), tree(file.getContents()) {}
+
+        bool isValid() const { return file.isMapped() && tree.isValid(); }
+        const FlatTree *getTree() const { return &tree; }
+
+    private:
+        MappedFile file;
+        FlatTree tree;
+    };
+
+    /**
+     * Constructor.
+     * @param directory the cache directory, created if necessary.
+     * @param sizeLimit the most bytes of entries to keep.
+     */
+    AstCache(const string &directory, uint64_t sizeLimit)
+        : entries(directory, sizeLimit) {}
+
+    /**
+     * Look up the compiled tree of a source.
+     * @param source the source text.
+     * @return the mapped tree, or null if it isn't cached.
+     */
+    Mapping *lookup(string_view source);
+
+    /**
+     * Store the compiled tree of a source.
+     * @param source the source text.
+     * @param root the root of its parse tree.
+     * @param slotNames its variables' names indexed by slot.
+     */
+    void store(string_view source, Node *root,
+               const vector<string> &slotNames);
+
+private:
+    CacheDirectory entries;
+};
+
+#endif /* ASTCACHE_H_ */
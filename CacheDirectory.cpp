@@ -0,0 +1,129 @@
+/**
+ * Cache directory for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "Hash.h"
+#include "CacheDirectory.h"
+
+using namespace std;
+
+CacheDirectory::CacheDirectory(const string &directory, uint64_t sizeLimit)
+    : directory(directory), sizeLimit(sizeLimit)
+{
+    mkdir(directory.c_str(), 0777);
+
+    // Anything that rebuilds or replaces the executable
+    // changes its size, modification time, or inode.
+    struct stat status;
+    memset(&status, 0, sizeof(status));
+    stat("/proc/self/exe", &status);
+
+    uint64_t identity[] =
+    {
+        (uint64_t) status.st_size, (uint64_t) status.st_mtim.tv_sec,
+        (uint64_t) status.st_mtim.tv_nsec, (uint64_t) status.st_ino
+    };
+    interpreterHash = hash64(string_view((const char *) identity,
+                                         sizeof(identity)));
+}
+
+string CacheDirectory::entryPath(string_view key, const char *suffix) const
+{
+    return directory + "/" + hashString(hash64(key, interpreterHash))
+                     + suffix;
+}
+
+void CacheDirectory::touch(const string &path) const
+{
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+}
+
+void CacheDirectory::store(const string &path,
+                           initializer_list<string_view> parts)
+{
+    static atomic<unsigned> sequence(0);
+
+    // The temporary file's name starts with a dot so that eviction
+    // ignores it, and it's unique to this thread's store.
+    string temporary = directory + "/." + path.substr(directory.size() + 1)
+                     + "." + to_string(getpid())
+                     + "." + to_string(sequence++);
+
+    FILE *entry = fopen(temporary.c_str(), "wb");
+    if (entry == nullptr) return;  // a cache is only an optimization
+
+    for (string_view part : parts) fwrite(part.data(), 1, part.size(), entry);
+
+    if (fclose(entry) == 0) rename(temporary.c_str(), path.c_str());
+    else                    unlink(temporary.c_str());
+
+    evict();
+}
+
+/**
+ * Delete the least recently used entries until the
+ * directory is within its size limit.
+ */
+void CacheDirectory::evict()
+{
+    struct Entry
+    {
+        string path;
+        uint64_t size;
+        timespec used;
+    };
+
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) return;
+
+    vector<Entry> entries;
+    uint64_t total = 0;
+
+    while (dirent *file = readdir(dir))
+    {
+        string path = directory + "/" + file->d_name;
+        struct stat status;
+
+        if (   (file->d_name[0] != '.')
+            && (stat(path.c_str(), &status) == 0)
+            && S_ISREG(status.st_mode))
+        {
+            entries.push_back(Entry{path, (uint64_t) status.st_size,
+                                    status.st_mtim});
+            total += status.st_size;
+        }
+    }
+
+    closedir(dir);
+    if (total <= sizeLimit) return;
+
+    sort(entries.begin(), entries.end(),
+         [](const Entry &a, const Entry &b)
+         {
+             return   a.used.tv_sec != b.used.tv_sec
+                    ? a.used.tv_sec  < b.used.tv_sec
+                    : a.used.tv_nsec < b.used.tv_nsec;
+         });
+
+    for (const Entry &entry : entries)
+    {
+        if (total <= sizeLimit) break;
+
+        unlink(entry.path.c_str());
+        total -= entry.size;
+    }
+}
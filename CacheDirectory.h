@@ -0,0 +1,68 @@
+/**
+ * Cache directory for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CACHEDIRECTORY_H_
+#define CACHEDIRECTORY_H_
+
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * A directory of cache entry files with a size limit.
+ *
+ * Entries are named by hashes that include the interpreter's
+ * identity, so rebuilding or reinstalling the interpreter invalidates
+ * every entry. An entry is written to a temporary file and renamed
+ * into place, so concurrent readers and writers never see a partial
+ * entry. Reading an entry should touch it, and each store evicts the
+ * least recently used entries while the directory is over its limit.
+ */
+class CacheDirectory
+{
+public:
+    /**
+     * Constructor.
+     * @param directory the directory, created if necessary.
+     * @param sizeLimit the most bytes of entries to keep.
+     */
+    CacheDirectory(const string &directory, uint64_t sizeLimit);
+
+    /**
+     * Make the path of an entry.
+     * @param key the entry's key, e.g. a hash of the source it's for.
+     * @param suffix the file name suffix for this kind of entry.
+     * @return the path.
+     */
+    string entryPath(string_view key, const char *suffix) const;
+
+    /**
+     * Mark an entry as recently used.
+     * @param path the entry's path.
+     */
+    void touch(const string &path) const;
+
+    /**
+     * Atomically create or replace an entry, then evict
+     * entries as necessary.
+     * @param path the entry's path.
+     * @param parts the entry's contents, in order.
+     */
+    void store(const string &path, initializer_list<string_view> parts);
+
+private:
+    string directory;
+    uint64_t sizeLimit;
+    uint64_t interpreterHash;  // identifies this build of the interpreter
+
+    void evict();
+};
+
+#endif /* CACHEDIRECTORY_H_ */
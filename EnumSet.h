@@ -0,0 +1,53 @@
+/**
+ * A constexpr set of enumeration values for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef ENUMSET_H_
+#define ENUMSET_H_
+
+#include <initializer_list>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * A set of values of an enumeration with at most 64 members,
+ * stored as a bit mask. Sets can be built at compile time, so a
+ * static set needs no initialization at startup, is safe to share
+ * among threads, and a membership test is a shift and a mask.
+ */
+template <typename E>
+class EnumSet
+{
+private:
+    uint64_t bits;
+
+public:
+    constexpr EnumSet() : bits(0) {}
+
+    constexpr EnumSet(initializer_list<E> members) : bits(0)
+    {
+        for (E member : members) bits |= bit(member);
+    }
+
+    /**
+     * Test membership.
+     * @param member the value to test.
+     * @return true if the value is in the set.
+     */
+    constexpr bool contains(E member) const
+    {
+        return (bits & bit(member)) != 0;
+    }
+
+private:
+    static constexpr uint64_t bit(E member)
+    {
+        return uint64_t(1) << (int) member;
+    }
+};
+
+#endif /* ENUMSET_H_ */
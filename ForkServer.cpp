@@ -0,0 +1,233 @@
+/**
+ * Fork server for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "Output.h"
+#include "Program.h"
+#include "ForkServer.h"
+
+using namespace std;
+
+bool ForkServer::preload(const string &sourceFileName)
+{
+    Program program = Program::compileFile(sourceFileName);
+
+    if (program.getError().getKind() == Error::Kind::SOURCE)
+    {
+        output().write(program.getError().getMessage());
+        return false;
+    }
+
+    programs.erase(sourceFileName);
+    programs.emplace(sourceFileName, program);
+
+    return true;
+}
+
+int ForkServer::serve(FILE *control)
+{
+    static const char *STATUS_STRINGS[] =
+    {
+        "ok", "syntax errors", "runtime error", "source error"
+    };
+
+    int failures = 0;
+    int jobCount = 0;
+    char line[4096];
+
+    while (fgets(line, sizeof(line), control) != nullptr)
+    {
+        string sourceFileName(line);
+        size_t first = sourceFileName.find_first_not_of(" \t\r\n");
+        if ((first == string::npos) || (sourceFileName[first] == '#')) continue;
+
+        size_t last = sourceFileName.find_last_not_of(" \t\r\n");
+        sourceFileName = sourceFileName.substr(first, last - first + 1);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        bool timedOut;
+        int status = runJob(sourceFileName, &timedOut);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now()
+                                                    - start).count();
+
+        // Describe how the child ended.
+        string outcome;
+        if (WIFEXITED(status) && (WEXITSTATUS(status) <= SOURCE_ERROR))
+        {
+            outcome = STATUS_STRINGS[WEXITSTATUS(status)];
+        }
+        else if (timedOut)
+        {
+            outcome = "wall time limit exceeded";
+        }
+        else if (WIFSIGNALED(status) && (WTERMSIG(status) == SIGXCPU))
+        {
+            outcome = "cpu time limit exceeded";
+        }
+        else if (WIFSIGNALED(status))
+        {
+            outcome = string("killed by ") + strsignal(WTERMSIG(status));
+        }
+        else outcome = "failed";
+
+        bool preloaded = programs.find(sourceFileName) != programs.end();
+        fprintf(stderr, "forkserver: %s: %s, %s, %.3f ms\n",
+                sourceFileName.c_str(), preloaded ? "preloaded" : "compiled",
+                outcome.c_str(), ms);
+
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != OK)) failures++;
+        jobCount++;
+    }
+
+    fprintf(stderr, "forkserver: %d jobs, %d failed\n", jobCount, failures);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Fork a child to run a job and wait for it to exit.
+ * @param sourceFileName the job's source file name.
+ * @param timedOut set to whether the child was killed for taking
+ *                 too long in wall time.
+ * @return the child's wait status.
+ */
+int ForkServer::runJob(const string &sourceFileName, bool *timedOut)
+{
+    *timedOut = false;
+
+    // Don't let the child inherit and repeat buffered output.
+    fflush(stdout);
+    fflush(stderr);
+
+    // Hold SIGCHLD pending so that the master can wait for it
+    // with a timeout.
+    sigset_t childSignal, previous;
+    sigemptyset(&childSignal);
+    sigaddset(&childSignal, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childSignal, &previous);
+
+    pid_t child = fork();
+
+    if (child == 0)
+    {
+        sigprocmask(SIG_SETMASK, &previous, nullptr);
+
+        if (cpuLimit > 0)
+        {
+            struct rlimit limit;
+            limit.rlim_cur = cpuLimit;
+            limit.rlim_max = cpuLimit + 1;
+            setrlimit(RLIMIT_CPU, &limit);
+        }
+
+        auto found = programs.find(sourceFileName);
+        int exitStatus = found != programs.end()
+                            ? execute(found->second)
+                            : execute(Program::compileFile(sourceFileName));
+
+        // Skip the destructors: the process is about to vanish anyway.
+        fflush(stdout);
+        _exit(exitStatus);
+    }
+
+    int status = -1;
+    if (child < 0)
+    {
+        fprintf(stderr, "*** ERROR: fork failed: %s\n", strerror(errno));
+    }
+    else status = waitForChild(child, timedOut);
+
+    sigprocmask(SIG_SETMASK, &previous, nullptr);
+    return status;
+}
+
+/**
+ * Wait for a child to exit, and kill it if it outlives its wall time
+ * limit. SIGCHLD must be blocked.
+ * @param child the child's process id.
+ * @param timedOut set to true if the child was killed.
+ * @return the child's wait status.
+ */
+int ForkServer::waitForChild(pid_t child, bool *timedOut)
+{
+    int status = -1;
+
+    if (cpuLimit == 0)
+    {
+        while ((waitpid(child, &status, 0) < 0) && (errno == EINTR)) {}
+        return status;
+    }
+
+    chrono::steady_clock::time_point deadline =
+          chrono::steady_clock::now()
+        + chrono::seconds(cpuLimit*WALL_TIME_FACTOR);
+    pid_t done;
+
+    sigset_t childSignal;
+    sigemptyset(&childSignal);
+    sigaddset(&childSignal, SIGCHLD);
+
+    while ((done = waitpid(child, &status, WNOHANG)) == 0)
+    {
+        chrono::steady_clock::duration left =
+            deadline - chrono::steady_clock::now();
+
+        if (left <= chrono::steady_clock::duration::zero())
+        {
+            kill(child, SIGKILL);
+            *timedOut = true;
+            while ((waitpid(child, &status, 0) < 0) && (errno == EINTR)) {}
+            return status;
+        }
+
+        // Sleep until some child exits or the deadline passes.
+        long ns = chrono::duration_cast<chrono::nanoseconds>(left).count();
+        struct timespec timeout;
+        timeout.tv_sec  = ns/1000000000;
+        timeout.tv_nsec = ns%1000000000;
+        sigtimedwait(&childSignal, nullptr, &timeout);
+    }
+
+    return done > 0 ? status : -1;
+}
+
+/**
+ * Execute a compiled program, writing its output and any errors
+ * to the output.
+ * @param program the program.
+ * @return the exit status for how the run ended.
+ */
+int ForkServer::execute(const Program &program)
+{
+    Error error = program.getError();
+
+    if (!error.failed())
+    {
+        Context context = program.newContext();
+        error = program.run(context, output());
+    }
+
+    output().write(error.getMessage());
+
+    switch (error.getKind())
+    {
+        case Error::Kind::SOURCE  : return SOURCE_ERROR;
+        case Error::Kind::SYNTAX  : return SYNTAX_ERRORS;
+        case Error::Kind::RUNTIME : return RUNTIME_ERROR;
+        default                   : return OK;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * Fork server for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef FORKSERVER_H_
+#define FORKSERVER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "Program.h"
+
+using namespace std;
+
+/**
+ * A master process that compiles a set of programs once and then
+ * forks a child process to run each job. A child inherits the
+ * master's compiled parse trees and warm heap copy-on-write, so it
+ * starts without scanning or parsing, and a program that crashes or
+ * runs away takes down only its own child.
+ *
+ * Jobs arrive on a control stream, one source file name per line.
+ * A job for a program that wasn't preloaded is compiled in its child.
+ * Each job's output goes to stdout, and a status line for each job
+ * goes to stderr once its child exits. A child that runs past its CPU
+ * time limit, or blocks past its wall time limit, is killed so that
+ * the jobs queued behind it still run.
+ */
+class ForkServer
+{
+public:
+    // A child's CPU time limit in seconds unless told otherwise.
+    static const int DEFAULT_CPU_LIMIT = 10;
+
+    // A child that blocks uses no CPU time, so it's also killed once
+    // it has run for this many times its CPU time limit.
+    static const int WALL_TIME_FACTOR = 2;
+
+    /**
+     * Constructor.
+     * @param cpuLimit each child's CPU time limit in seconds,
+     *                 or 0 for no CPU or wall time limit.
+     */
+    ForkServer(int cpuLimit = DEFAULT_CPU_LIMIT) : cpuLimit(cpuLimit) {}
+
+    /**
+     * Compile a program now so that its jobs can skip compilation.
+     * @param sourceFileName the program's source file name.
+     * @return false if the program couldn't be read,
+     *         after writing a message to stdout.
+     */
+    bool preload(const string &sourceFileName);
+
+    /**
+     * Run the jobs named on a control stream until it ends.
+     * @param control the control stream.
+     * @return 0 if every job ran cleanly, else 1.
+     */
+    int serve(FILE *control);
+
+private:
+    // A child's exit status for each way a run can end.
+    enum ExitStatus { OK, SYNTAX_ERRORS, RUNTIME_ERROR, SOURCE_ERROR };
+
+    int cpuLimit;
+    unordered_map<string, Program> programs;  // preloaded, by file name
+
+    int runJob(const string &sourceFileName, bool *timedOut);
+    int waitForChild(pid_t child, bool *timedOut);
+    static int execute(const Program &program);
+};
+
+#endif /* FORKSERVER_H_ */
@@ -0,0 +1,48 @@
+/**
+ * Content hashing for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <string>
+#include <string_view>
+#include <stdint.h>
+#include <stdio.h>
+
+using namespace std;
+
+/**
+ * Compute the 64-bit FNV-1a hash of some bytes.
+ * @param data the bytes.
+ * @param hash the starting value, to continue an earlier hash.
+ * @return the hash value.
+ */
+inline uint64_t hash64(string_view data,
+                       uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char byte : data)
+    {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/**
+ * @param hash a hash value.
+ * @return the hash value as 16 hexadecimal digits.
+ */
+inline string hashString(uint64_t hash)
+{
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) hash);
+
+    return buffer;
+}
+
+#endif /* HASH_H_ */
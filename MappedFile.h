@@ -0,0 +1,80 @@
+/**
+ * Memory-mapped file for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+/**
+ * A whole file mapped read-only into memory for as long
+ * as this object exists.
+ */
+class MappedFile
+{
+private:
+    void *address;  // null if the file couldn't be mapped
+    size_t size;
+
+public:
+    /**
+     * Constructor.
+     * @param path the file's path.
+     */
+    MappedFile(const string &path) : address(nullptr), size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat status;
+        if ((fstat(fd, &status) == 0) && (status.st_size > 0))
+        {
+            void *mapped = mmap(nullptr, status.st_size, PROT_READ,
+                                MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED)
+            {
+                address = mapped;
+                size = status.st_size;
+            }
+        }
+
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator =(const MappedFile &) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~MappedFile()
+    {
+        if (address != nullptr) munmap(address, size);
+    }
+
+    /**
+     * @return true if the file is mapped.
+     */
+    bool isMapped() const { return address != nullptr; }
+
+    /**
+     * @return the file's contents.
+     */
+    string_view getContents() const
+    {
+        return string_view((const char *) address, size);
+    }
+};
+
+#endif /* MAPPEDFILE_H_ */
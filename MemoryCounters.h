@@ -0,0 +1,61 @@
+/**
+ * Memory statistics counters for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef MEMORYCOUNTERS_H_
+#define MEMORYCOUNTERS_H_
+
+using namespace std;
+
+/**
+ * Counts of the heap allocations and shared parse tree nodes that a
+ * thread has made, for a driver that reports memory use. The parser
+ * counts the nodes it shares. Allocations are counted only if the
+ * driver links in AllocationCounting.cpp, which replaces the global
+ * operator new, so a host that embeds the interpreter keeps its own
+ * allocator. Each thread has its own counters, so counting needs no
+ * atomic operations, and work timed on different threads doesn't mix.
+ */
+struct MemoryCounters
+{
+    long allocations;
+    long bytes;        // bytes allocated
+    long sharedNodes;  // tree nodes shared instead of allocated
+
+    /**
+     * @return the calling thread's counters.
+     */
+    static MemoryCounters &forThread()
+    {
+        // Constant-initialized, so safe to use inside operator new.
+        static thread_local MemoryCounters counters = { 0, 0, 0 };
+        return counters;
+    }
+
+    /**
+     * Add the counts of work done on another thread on this one's behalf.
+     * @param other the other counts.
+     */
+    void add(const MemoryCounters &other)
+    {
+        allocations += other.allocations;
+        bytes       += other.bytes;
+        sharedNodes += other.sharedNodes;
+    }
+
+    /**
+     * @param earlier the counts at an earlier time.
+     * @return the counts since then.
+     */
+    MemoryCounters since(const MemoryCounters &earlier) const
+    {
+        return MemoryCounters{ allocations - earlier.allocations,
+                               bytes       - earlier.bytes,
+                               sharedNodes - earlier.sharedNodes };
+    }
+};
+
+#endif /* MEMORYCOUNTERS_H_ */
@@ -1,6 +1,6 @@
 /**
  * An object class for a simple interpreter.
- * A quick-and-dirty Any implementation.
+ * A compact tagged Any implementation.
  *
  * (c) 2020 by Ronald Mak
  * Department of Computer Science
@@ -10,23 +10,109 @@
 #define OBJECT_H_
 
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <unordered_set>
+#include <mutex>
 
 using namespace std;
 
+/**
+ * A pool of interned strings: the one immutable copy shared by every
+ * equal string. The scanner interns every string literal, so a pool
+ * is a constant pool. Interned strings live as long as their pool and
+ * are never modified, so views into them can be handed out freely.
+ */
+class ConstantPool
+{
+public:
+    /**
+     * Intern a string.
+     * @param str the string.
+     * @return a pointer to the shared copy.
+     */
+    const string *intern(const string &str)
+    {
+        lock_guard<mutex> guard(lock);
+        return &*strings.insert(str).first;
+    }
+
+    /**
+     * @return the pool that lives until the process exits, for sources
+     *         that aren't given a pool of their own.
+     */
+    static ConstantPool &global()
+    {
+        static ConstantPool pool;
+        return pool;
+    }
+
+private:
+    unordered_set<string> strings;
+    mutex lock;
+};
+
+/**
+ * Intern a string in the global pool.
+ * @param str the string.
+ * @return a pointer to the shared copy.
+ */
+inline const string *intern(const string &str)
+{
+    return ConstantPool::global().intern(str);
+}
+
+/**
+ * A 16-byte tagged value: a type tag plus a union of a long, a double,
+ * a bool, or a handle to an interned string. Objects are cheap to copy.
+ * A long can also be read as a double, and a double as a long.
+ * Reading any other kind of value than the one stored gives the
+ * zero value of the type that was asked for.
+ */
 class Object
 {
 public:
-    long   L;
-    double D;
-    string S;
-    bool   B;
-
-    Object()             : L(0),     D(0.0),   S(""),    B(false) {}
-    Object(long value)   : L(value), D(0.0),   S(""),    B(false) {}
-    Object(double value) : L(0),     D(value), S(""),    B(false) {}
-    Object(string value) : L(0),     D(0.0),   S(value), B(false) {}
-    Object(bool value)   : L(0),     D(0.0),   S(""),    B(value) {}
+    enum class Type : unsigned char { NONE, LONG, DOUBLE, STRING, BOOL };
+
+    Object()             : type(Type::NONE)   { u.l = 0; }
+    Object(long value)   : type(Type::LONG)   { u.l = value; }
+    Object(double value) : type(Type::DOUBLE) { u.d = value; }
+    Object(string value) : type(Type::STRING) { u.s = intern(value); }
+    Object(const string *interned) : type(Type::STRING) { u.s = interned; }
+    Object(bool value)   : type(Type::BOOL)   { u.l = 0; u.b = value; }
+
+    Type getType() const { return type; }
+
+    long L() const
+    {
+        return type == Type::LONG   ? u.l
+             : type == Type::DOUBLE ? (long) u.d
+             :                        0;
+    }
+
+    double D() const
+    {
+        return type == Type::DOUBLE ? u.d
+             : type == Type::LONG   ? (double) u.l
+             :                        0.0;
+    }
+
+    string_view S() const
+    {
+        return type == Type::STRING ? string_view(*u.s) : string_view();
+    }
+
+    bool B() const { return type == Type::BOOL ? u.b : false; }
+
+private:
+    Type type;
+    union
+    {
+        long          l;
+        double        d;
+        bool          b;
+        const string *s;  // interned
+    } u;
 };
 
 /**
@@ -0,0 +1,157 @@
+/**
+ * Output sinks for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <string>
+#include <string_view>
+#include <stdio.h>
+#include <stdarg.h>
+
+using namespace std;
+
+/**
+ * Where a program's output and diagnostics go. The frontend and
+ * backend write through output(), never to stdout directly, so a
+ * driver can capture each program's output separately.
+ */
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+
+    /**
+     * Write characters.
+     * @param data the characters.
+     * @param length how many.
+     */
+    virtual void write(const char *data, size_t length) = 0;
+
+    void write(string_view text) { write(text.data(), text.size()); }
+    void put(char ch)            { write(&ch, 1); }
+
+    /**
+     * Write formatted text, as printf does.
+     * @param format the format string.
+     */
+    void print(const char *format, ...)
+        __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[256];
+
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        if (length < (int) sizeof(buffer))
+        {
+            write(buffer, length);
+            return;
+        }
+
+        // Too long for the stack buffer.
+        string text(length, '\0');
+        va_start(args, format);
+        vsnprintf(&text[0], length + 1, format, args);
+        va_end(args);
+
+        write(text);
+    }
+};
+
+/**
+ * An output sink that writes to a stdio stream.
+ */
+class FileSink : public OutputSink
+{
+private:
+    FILE *file;
+
+public:
+    FileSink(FILE *file) : file(file) {}
+
+    void write(const char *data, size_t length) override
+    {
+        fwrite(data, 1, length, file);
+    }
+};
+
+/**
+ * An output sink that collects its output in a string.
+ */
+class StringSink : public OutputSink
+{
+private:
+    string text;
+
+public:
+    void write(const char *data, size_t length) override
+    {
+        text.append(data, length);
+    }
+
+    const string &getText() const { return text; }
+    void clear() { text.clear(); }
+};
+
+/**
+ * An output sink that passes its output on to another sink
+ * and also keeps a copy of it.
+ */
+class TeeSink : public StringSink
+{
+private:
+    OutputSink *next;
+
+public:
+    TeeSink(OutputSink *next) : next(next) {}
+
+    void write(const char *data, size_t length) override
+    {
+        next->write(data, length);
+        StringSink::write(data, length);
+    }
+};
+
+/**
+ * The calling thread's current output sink pointer.
+ * It points to a sink for stdout until a thread redirects it.
+ */
+inline OutputSink *&currentOutput()
+{
+    static FileSink standardOutput(stdout);
+    static thread_local OutputSink *sink = &standardOutput;
+
+    return sink;
+}
+
+/**
+ * @return the calling thread's current output sink.
+ */
+inline OutputSink &output() { return *currentOutput(); }
+
+/**
+ * Redirect the calling thread's output to a sink for as long as
+ * the redirection object exists.
+ */
+class OutputRedirect
+{
+private:
+    OutputSink *saved;
+
+public:
+    OutputRedirect(OutputSink *sink) : saved(currentOutput())
+    {
+        currentOutput() = sink;
+    }
+
+    ~OutputRedirect() { currentOutput() = saved; }
+};
+
+#endif /* OUTPUT_H_ */
@@ -0,0 +1,66 @@
+/**
+ * Output cache for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <stdio.h>
+#include <string.h>
+
+#include "Hash.h"
+#include "OutputCache.h"
+
+using namespace std;
+
+// Identifies the layout of the entry files.
+static const char MAGIC[] = "simple output cache 1\n";
+
+// The hash of the source that's stored in an entry to confirm a hit.
+// It has a different starting value from the hash in the file name,
+// so two sources would have to collide in both.
+static const uint64_t CHECK_BASIS = 0x6a09e667f3bcc908ULL;
+
+bool OutputCache::lookup(string_view source, OutputSink &out, int *status)
+{
+    string path = entries.entryPath(source, ".out");
+    FILE *entry = fopen(path.c_str(), "rb");
+    if (entry == nullptr) return false;
+
+    // Check the header: the magic line, then the source's length,
+    // its check hash, and the run status.
+    char magic[sizeof(MAGIC)];
+    unsigned long long length, check;
+    bool hit =    (fgets(magic, sizeof(magic), entry) != nullptr)
+               && (strcmp(magic, MAGIC) == 0)
+               && (fscanf(entry, "%llu %llx %d", &length, &check, status) == 3)
+               && (fgetc(entry) == '\n')
+               && (length == source.size())
+               && (check == hash64(source, CHECK_BASIS));
+
+    if (hit)
+    {
+        char buffer[65536];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), entry)) > 0)
+        {
+            out.write(buffer, count);
+        }
+
+        entries.touch(path);
+    }
+
+    fclose(entry);
+    return hit;
+}
+
+void OutputCache::store(string_view source, string_view output, int status)
+{
+    char header[64];
+    snprintf(header, sizeof(header), "%zu %s %d\n", source.size(),
+             hashString(hash64(source, CHECK_BASIS)).c_str(), status);
+
+    entries.store(entries.entryPath(source, ".out"),
+                  { MAGIC, header, output });
+}
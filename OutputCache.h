@@ -0,0 +1,59 @@
+/**
+ * Output cache for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef OUTPUTCACHE_H_
+#define OUTPUTCACHE_H_
+
+#include <string>
+#include <string_view>
+#include <stdint.h>
+
+#include "CacheDirectory.h"
+#include "Output.h"
+
+using namespace std;
+
+/**
+ * An on-disk cache of program outputs. The language has no input
+ * statements, so a program's output, including any error messages,
+ * depends only on its source text and on the interpreter itself.
+ * A program that's run again unchanged can therefore have its output
+ * replayed without being scanned, parsed, or executed.
+ */
+class OutputCache
+{
+public:
+    /**
+     * Constructor.
+     * @param directory the cache directory, created if necessary.
+     * @param sizeLimit the most bytes of entries to keep.
+     */
+    OutputCache(const string &directory, uint64_t sizeLimit)
+        : entries(directory, sizeLimit) {}
+
+    /**
+     * Look up a program's output.
+     * @param source the program's source text.
+     * @param out where to write the output if it's cached.
+     * @param status set to the run status that was stored with it.
+     * @return true if it was cached.
+     */
+    bool lookup(string_view source, OutputSink &out, int *status);
+
+    /**
+     * Store a program's output.
+     * @param source the program's source text.
+     * @param output everything the program wrote.
+     * @param status how its run ended.
+     */
+    void store(string_view source, string_view output, int status);
+
+private:
+    CacheDirectory entries;
+};
+
+#endif /* OUTPUTCACHE_H_ */
@@ -0,0 +1,148 @@
+/**
+ * Embedding interface for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <string_view>
+#include <exception>
+
+#include "frontend/Source.h"
+#include "frontend/Scanner.h"
+#include "frontend/Parser.h"
+#include "backend/Executor.h"
+#include "Program.h"
+
+using namespace std;
+using namespace frontend;
+
+Program Program::compile(string_view text, const vector<string> &inputs,
+                         const string &name)
+{
+    Source source(text, name);
+    return compile(&source, inputs);
+}
+
+Program Program::compileFile(const string &sourceFileName,
+                             const vector<string> &inputs)
+{
+    try
+    {
+        Source source(sourceFileName);
+        return compile(&source, inputs);
+    }
+    catch (SourceError &error)
+    {
+        Compiled *compiled = new Compiled();
+        compiled->error = Error(Error::Kind::SOURCE,
+                                string(error.what()) + "\n");
+
+        return Program(shared_ptr<const Compiled>(compiled));
+    }
+}
+
+/**
+ * Compile a program from its source.
+ * @param source the source.
+ * @param inputs the names of the program's input variables.
+ * @return the program.
+ */
+Program Program::compile(Source *source, const vector<string> &inputs)
+{
+    Compiled *compiled = new Compiled();
+
+    // The program's string literals go when it does, so that a
+    // long-running embedder doesn't accumulate them.
+    source->setConstantPool(&compiled->constants);
+
+    // Declare the inputs up front so that the parser accepts
+    // reads of them that aren't preceded by assignments.
+    for (const string &input : inputs)
+    {
+        if (compiled->symtab.lookup(input) == nullptr)
+        {
+            compiled->symtab.enter(input);
+        }
+    }
+    StringSink diagnostics;
+    {
+        OutputRedirect redirect(&diagnostics);
+
+        try
+        {
+            Scanner scanner(source);
+            Parser parser(&scanner, &compiled->symtab);
+
+            compiled->tree = parser.parseProgram();
+
+            int errorCount = parser.getErrorCount();
+            if (errorCount > 0)
+            {
+                output().print("\nThere were %d errors.\n", errorCount);
+                delete compiled->tree;
+                compiled->tree = nullptr;
+            }
+        }
+        catch (const exception &ex)
+        {
+            // Report anything unexpected as an error, never an abort.
+            output().print("*** ERROR: %s\n", ex.what());
+            delete compiled->tree;
+            compiled->tree = nullptr;
+        }
+    }
+
+    if (compiled->tree == nullptr)
+    {
+        compiled->error = Error(Error::Kind::SYNTAX, diagnostics.getText());
+    }
+
+    return Program(shared_ptr<const Compiled>(compiled));
+}
+
+int Program::slotOf(string_view name) const
+{
+    const SymtabEntry *entry = compiled->symtab.lookup(name);
+    return entry != nullptr ? entry->getSlot() : -1;
+}
+
+double Program::get(const Context &context, string_view name) const
+{
+    return get(context, slotOf(name));
+}
+
+bool Program::set(Context &context, string_view name, double value) const
+{
+    return set(context, slotOf(name), value);
+}
+
+Error Program::run(Context &context, OutputSink &sink) const
+{
+    if (compiled->tree == nullptr) return compiled->error;
+
+    // The executor doesn't check slots, so the context must have them all.
+    if (context.values.size() < (size_t) getSlotCount())
+    {
+        return Error(Error::Kind::RUNTIME,
+                     "*** ERROR: The context has "
+                     + to_string(context.values.size())
+                     + " variable slots but the program needs "
+                     + to_string(getSlotCount()) + "\n");
+    }
+
+    OutputRedirect redirect(&sink);
+    Executor executor(&context);
+
+    try
+    {
+        executor.visit(compiled->tree);
+    }
+    catch (RuntimeError &error)
+    {
+        return Error(Error::Kind::RUNTIME, string(error.what()) + "\n");
+    }
+
+    return Error();
+}
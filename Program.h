@@ -0,0 +1,192 @@
+/**
+ * Embedding interface for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef PROGRAM_H_
+#define PROGRAM_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include "intermediate/Symtab.h"
+#include "intermediate/Node.h"
+#include "backend/Context.h"
+#include "Output.h"
+
+namespace frontend { class Source; }
+
+using namespace std;
+using namespace intermediate;
+using namespace backend;
+
+/**
+ * Why compiling or running a program failed, if it did.
+ * The message is the complete text the interpreter would have printed.
+ */
+class Error
+{
+public:
+    enum class Kind { NONE, SOURCE, SYNTAX, RUNTIME };
+
+    Error() : kind(Kind::NONE) {}
+    Error(Kind kind, string message) : kind(kind), message(message) {}
+
+    Kind getKind() const { return kind; }
+    const string &getMessage() const { return message; }
+
+    /**
+     * @return true if there was an error.
+     */
+    bool failed() const { return kind != Kind::NONE; }
+
+private:
+    Kind kind;
+    string message;
+};
+
+/**
+ * A compiled program, for running in-process any number of times.
+ * Compile once, then run with a fresh or preset Context each time:
+ *
+ *     Program program = Program::compile(text, {"n"});
+ *     if (program.getError().failed()) ...
+ *
+ *     Context context = program.newContext();
+ *     program.set(context, "n", 42);
+ *     Error error = program.run(context, sink);
+ *
+ * Nothing here reads files (except compileFile()), writes to stdout,
+ * or exits. A Program is cheap to copy and never changes after
+ * compilation, so threads can run it concurrently, each in its own
+ * Context.
+ */
+class Program
+{
+public:
+    /**
+     * Compile program text.
+     * @param text the source text.
+     * @param inputs the names of variables that the program may read
+     *               without assigning them first, for the caller to set.
+     * @param name a name for the source.
+     * @return the program. Check getError() before running it.
+     */
+    static Program compile(string_view text,
+                           const vector<string> &inputs = {},
+                           const string &name = "<source>");
+
+    /**
+     * Compile a source file.
+     * @param sourceFileName the source file name.
+     * @param inputs the names of the program's input variables.
+     * @return the program. Check getError() before running it.
+     */
+    static Program compileFile(const string &sourceFileName,
+                               const vector<string> &inputs = {});
+
+    /**
+     * Getter.
+     * @return the source or syntax errors, or no error.
+     */
+    const Error &getError() const { return compiled->error; }
+
+    /**
+     * Getter.
+     * @return the parse tree, or null if there were errors.
+     */
+    Node *getTree() const { return compiled->tree; }
+
+    /**
+     * Getter.
+     * @return the number of variable slots a context needs.
+     */
+    int getSlotCount() const { return compiled->symtab.size(); }
+
+    /**
+     * @return a context with every variable set to zero.
+     */
+    Context newContext() const { return Context(getSlotCount()); }
+
+    /**
+     * Look up a variable's slot.
+     * @param name the variable's name, in any case.
+     * @return the slot, or -1 if the program has no such variable.
+     */
+    int slotOf(string_view name) const;
+
+    /**
+     * Get a variable's value.
+     * @param context the context to read.
+     * @param name the variable's name.
+     * @return the value, or 0 if the program has no such variable.
+     */
+    double get(const Context &context, string_view name) const;
+    double get(const Context &context, int slot) const
+    {
+        return fits(context, slot) ? context.values[slot] : 0.0;
+    }
+
+    /**
+     * Set a variable's value, e.g. before a run.
+     * @param context the context to write.
+     * @param name the variable's name.
+     * @param value the value.
+     * @return false if the program has no such variable,
+     *         or the context has no such slot.
+     */
+    bool set(Context &context, string_view name, double value) const;
+    bool set(Context &context, int slot, double value) const
+    {
+        if (!fits(context, slot)) return false;
+
+        context.values[slot] = value;
+        return true;
+    }
+
+    /**
+     * Run the program.
+     * @param context the variable values to run with, from newContext(),
+     *                and which hold the values the run leaves behind.
+     * @param sink where the program's output goes.
+     * @return the runtime error, the compile error if the program
+     *         didn't compile, or no error. A context with too few
+     *         slots for the program is a runtime error.
+     */
+    Error run(Context &context, OutputSink &sink) const;
+
+private:
+    struct Compiled
+    {
+        ConstantPool constants;  // the tree's string literals
+        Node *tree = nullptr;
+        Symtab symtab;
+        Error error;
+
+        ~Compiled() { delete tree; }
+    };
+
+    shared_ptr<const Compiled> compiled;
+
+    Program(shared_ptr<const Compiled> compiled) : compiled(compiled) {}
+
+    static Program compile(frontend::Source *source,
+                           const vector<string> &inputs);
+
+    /**
+     * @param context a context.
+     * @param slot a slot index.
+     * @return true if the slot is one of the program's and the context's.
+     */
+    bool fits(const Context &context, int slot) const
+    {
+        return    (slot >= 0) && (slot < getSlotCount())
+               && (slot < (int) context.values.size());
+    }
+};
+
+#endif /* PROGRAM_H_ */
@@ -0,0 +1,191 @@
+/**
+ * Interactive read-eval-print loop for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <stdio.h>
+
+#include "frontend/Source.h"
+#include "frontend/Scanner.h"
+#include "frontend/Parser.h"
+#include "frontend/Token.h"
+#include "backend/Executor.h"
+#include "EnumSet.h"
+#include "Output.h"
+#include "Repl.h"
+
+using namespace std;
+using namespace frontend;
+
+/**
+ * Read a whole input line, however long it is.
+ * @param input where to read from.
+ * @param line set to the line, with its newline if it has one.
+ * @return false if there was nothing left to read.
+ */
+static bool readLine(FILE *input, string *line)
+{
+    char chunk[4096];
+    line->clear();
+
+    while (fgets(chunk, sizeof(chunk), input) != nullptr)
+    {
+        *line += chunk;
+        if (line->back() == '\n') return true;
+    }
+
+    return !line->empty();
+}
+
+int Repl::run(FILE *input, bool prompt)
+{
+    int failures = 0;
+    string text;
+    string line;
+
+    for (;;)
+    {
+        if (prompt)
+        {
+            fputs(text.empty() ? "> " : "| ", stdout);
+            fflush(stdout);
+        }
+
+        if (!readLine(input, &line)) break;
+
+        bool blank = line.find_first_not_of(" \t\r\n") == string::npos;
+        if (!blank) text += line;
+
+        if (!text.empty() && (blank || isComplete(text)))
+        {
+            if (!execute(text)) failures++;
+            fflush(stdout);
+            text.clear();
+        }
+    }
+
+    // Whatever is left over is as complete as it will ever be.
+    if (!text.empty() && !execute(text)) failures++;
+    if (prompt) putchar('\n');
+
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Decide whether input text is a complete statement sequence
+ * or whether more lines are needed.
+ * @param text the input text.
+ * @return true if it's complete.
+ */
+bool Repl::isComplete(const string &text)
+{
+    // Tokens that can't end a statement.
+    static constexpr EnumSet<TokenType> continuers =
+    {
+        TokenType::WHILE, TokenType::DO, TokenType::UNTIL, TokenType::NOT,
+        TokenType::COMMA, TokenType::COLON, TokenType::COLON_EQUALS,
+        TokenType::PLUS, TokenType::MINUS, TokenType::STAR, TokenType::SLASH,
+        TokenType::LPAREN, TokenType::EQUALS, TokenType::NOT_EQUALS,
+        TokenType::LESS_THAN, TokenType::LESS_EQUALS,
+        TokenType::GREATER_THAN, TokenType::GREATER_EQUALS,
+        TokenType::WRITE, TokenType::WRITELN
+    };
+
+    // Any token errors will be reported when the text is parsed.
+    StringSink discard;
+    OutputRedirect redirect(&discard);
+
+    // The tokens are only counted, so their strings can go with them.
+    ConstantPool constants;
+    Source source(text, "<repl>");
+    source.setConstantPool(&constants);
+    Scanner scanner(&source);
+
+    int depth = 0;        // unclosed BEGINs and REPEATs
+    int parentheses = 0;  // unclosed left parentheses
+    TokenType last = TokenType::END_OF_FILE;
+
+    for (;;)
+    {
+        Token *token = scanner.nextToken();
+        TokenType type = token->type;
+        delete token;
+
+        if (type == TokenType::END_OF_FILE) break;
+
+        switch (type)
+        {
+            case TokenType::BEGIN  :
+            case TokenType::REPEAT : depth++;       break;
+            case TokenType::END    :
+            case TokenType::UNTIL  : depth--;       break;
+            case TokenType::LPAREN : parentheses++; break;
+            case TokenType::RPAREN : parentheses--; break;
+
+            default : break;
+        }
+
+        last = type;
+    }
+
+    // WRITELN alone is a complete statement.
+    return    (depth <= 0) && (parentheses <= 0)
+           && ((last == TokenType::WRITELN) || !continuers.contains(last));
+}
+
+/**
+ * Compile and execute input text in the session's context.
+ * @param text the input text.
+ * @return true if it compiled and ran cleanly.
+ */
+bool Repl::execute(const string &text)
+{
+    int declaredCount = symtab.size();
+
+    // The input's string literals go when its tree does.
+    ConstantPool constants;
+    Source source(text, "<repl>");
+    source.setConstantPool(&constants);
+    Scanner scanner(&source);
+    Parser parser(&scanner, &symtab);
+
+    Node *compoundNode = parser.parseStatements();
+    bool ok = parser.getErrorCount() == 0;
+
+    if (ok)
+    {
+        // Make room for any variables the input introduced. The
+        // executor points into the context's values, so it's made
+        // afresh for each input once the context has grown.
+        context.values.resize(symtab.size(), 0.0);
+        Executor executor(&context);
+
+        try
+        {
+            executor.visit(compoundNode);
+        }
+        catch (RuntimeError &error)
+        {
+            output().print("%s\n", error.what());
+            ok = false;
+        }
+    }
+
+    delete compoundNode;
+
+    // Forget the variables that a failed input introduced, e.g. the
+    // target of an assignment whose expression had an error.
+    if (!ok)
+    {
+        symtab.truncate(declaredCount);
+        if ((int) context.values.size() > declaredCount)
+        {
+            context.values.resize(declaredCount);
+        }
+    }
+
+    return ok;
+}
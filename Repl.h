@@ -0,0 +1,53 @@
+/**
+ * Interactive read-eval-print loop for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef REPL_H_
+#define REPL_H_
+
+#include <string>
+#include <stdio.h>
+
+#include "intermediate/Symtab.h"
+#include "backend/Context.h"
+
+using namespace std;
+using namespace intermediate;
+using namespace backend;
+
+/**
+ * Reads statements interactively and executes each one as soon as
+ * it's complete. One symbol table and one execution context persist
+ * for the whole session, so variables keep their values from one
+ * input to the next, and only the new input is ever compiled.
+ *
+ * A statement can span lines: input is complete once every BEGIN
+ * and REPEAT has been closed and the last line doesn't end in the
+ * middle of a statement. An empty line forces the input so far to
+ * be compiled as is, e.g. to see the syntax error in it.
+ */
+class Repl
+{
+public:
+    Repl() : context(0) {}
+
+    /**
+     * Run the loop until the input ends.
+     * @param input where the statements come from.
+     * @param prompt true to prompt for each line.
+     * @return 0 if every input ran cleanly, else 1.
+     */
+    int run(FILE *input, bool prompt);
+
+private:
+    Symtab symtab;    // every variable of the session
+    Context context;  // and their values
+
+    static bool isComplete(const string &text);
+    bool execute(const string &text);
+};
+
+#endif /* REPL_H_ */
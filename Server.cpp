@@ -0,0 +1,287 @@
+/**
+ * Interpreter daemon for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "Hash.h"
+#include "Output.h"
+#include "Program.h"
+#include "Server.h"
+
+using namespace std;
+
+/**
+ * An output sink that buffers output and sends it to a socket.
+ * If the client goes away, further output is discarded.
+ */
+class SocketSink : public OutputSink
+{
+private:
+    int socket;
+    bool broken;
+    string buffer;
+
+    static const size_t BUFFER_SIZE = 8192;
+
+public:
+    SocketSink(int socket) : socket(socket), broken(false) {}
+    ~SocketSink() { flush(); }
+
+    using OutputSink::write;
+
+    void write(const char *data, size_t length) override
+    {
+        buffer.append(data, length);
+        if (buffer.size() >= BUFFER_SIZE) flush();
+    }
+
+    void flush()
+    {
+        for (size_t sent = 0; !broken && (sent < buffer.size()); )
+        {
+            ssize_t count = send(socket, buffer.data() + sent,
+                                 buffer.size() - sent, MSG_NOSIGNAL);
+            if (count < 0) broken = true;
+            else           sent += count;
+        }
+
+        buffer.clear();
+    }
+};
+
+bool ProgramServer::serve()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "*** ERROR: Socket path too long: %s\n",
+                socketPath.c_str());
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    // Remove a stale socket left by an earlier server, but nothing else.
+    struct stat status;
+    if ((stat(socketPath.c_str(), &status) == 0) && S_ISSOCK(status.st_mode))
+    {
+        unlink(socketPath.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (   (listener < 0)
+        || (bind(listener, (sockaddr *) &address, sizeof(address)) < 0)
+        || (listen(listener, SOMAXCONN) < 0))
+    {
+        fprintf(stderr, "*** ERROR: Failed to listen on %s: %s\n",
+                socketPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    fprintf(stderr, "serve: listening on %s\n", socketPath.c_str());
+
+    for (;;)
+    {
+        // Leave further clients waiting in the listen queue
+        // while the most connections are being served.
+        {
+            unique_lock<mutex> guard(connectionLock);
+            while (connectionCount >= MAX_CONNECTIONS)
+            {
+                connectionDone.wait(guard);
+            }
+        }
+
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR) continue;
+
+            fprintf(stderr, "*** ERROR: accept failed: %s\n", strerror(errno));
+            return false;
+        }
+
+        // Don't let a stalled client pin its thread.
+        struct timeval timeout;
+        timeout.tv_sec  = SOCKET_TIMEOUT_SECONDS;
+        timeout.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        {
+            lock_guard<mutex> guard(connectionLock);
+            connectionCount++;
+        }
+
+        thread(&ProgramServer::handle, this, client).detach();
+    }
+}
+
+/**
+ * Describe how a program's run ended.
+ * @param error the run's error, if any.
+ * @return the description.
+ */
+static const char *outcomeOf(const Error &error)
+{
+    switch (error.getKind())
+    {
+        case Error::Kind::SOURCE  : return "source error";
+        case Error::Kind::SYNTAX  : return "syntax errors";
+        case Error::Kind::RUNTIME : return "runtime error";
+        default                   : return "ok";
+    }
+}
+
+/**
+ * Handle one connection on its own thread. Whatever goes wrong with
+ * one request, the server must keep serving the others.
+ * @param client the connected socket.
+ */
+void ProgramServer::handle(int client)
+{
+    try
+    {
+        serve(client);
+    }
+    catch (const exception &ex)
+    {
+        fprintf(stderr, "serve: *** ERROR: %s\n", ex.what());
+    }
+
+    close(client);
+
+    lock_guard<mutex> guard(connectionLock);
+    connectionCount--;
+    connectionDone.notify_one();
+}
+
+/**
+ * Serve one connection: read a program, run it, and send its output.
+ * @param client the connected socket.
+ */
+void ProgramServer::serve(int client)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // Read the source until the client shuts down its side.
+    string source;
+    char chunk[65536];
+    ssize_t count;
+    while ((count = read(client, chunk, sizeof(chunk))) > 0)
+    {
+        source.append(chunk, count);
+
+        if (source.size() > MAX_SOURCE_SIZE)
+        {
+            SocketSink sink(client);
+            sink.print("*** ERROR: The source is larger than %zu bytes\n",
+                       MAX_SOURCE_SIZE);
+            fprintf(stderr, "serve: rejected a source over %zu bytes\n",
+                    MAX_SOURCE_SIZE);
+            return;
+        }
+    }
+
+    if (count < 0)
+    {
+        bool stalled = (errno == EAGAIN) || (errno == EWOULDBLOCK);
+        fprintf(stderr, "serve: *** ERROR: Failed to read the source: %s\n",
+                stalled ? "timed out" : strerror(errno));
+        return;
+    }
+
+    bool cached;
+    Program program = compile(source, &cached);
+    Error error = program.getError();
+
+    {
+        SocketSink sink(client);
+
+        if (!error.failed())
+        {
+            Context context = program.newContext();
+            error = program.run(context, sink);
+        }
+
+        sink.write(error.getMessage());
+    }
+
+    // Let the client see the end of the output before logging.
+    shutdown(client, SHUT_RDWR);
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now()
+                                                - start).count();
+    fprintf(stderr, "serve: %s %s, %s, %.3f ms\n",
+            hashString(hash64(source)).c_str(),
+            cached ? "cached" : "compiled", outcomeOf(error), ms);
+}
+
+/**
+ * Get a program's compiled form from the cache, or else compile it
+ * and add it to the cache.
+ * @param source the program source.
+ * @param cached set to true if the program was in the cache.
+ * @return the compiled program.
+ */
+Program ProgramServer::compile(const string &source, bool *cached)
+{
+    uint64_t hash = hash64(source);
+
+    {
+        lock_guard<mutex> guard(cacheLock);
+        auto found = cache.find(hash);
+
+        if ((found != cache.end()) && (found->second.source == source))
+        {
+            // Move the entry to the front of the LRU list.
+            recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed,
+                                found->second.recent);
+            *cached = true;
+
+            return found->second.program;
+        }
+    }
+
+    // Compile outside the lock so other connections aren't held up.
+    Program program = Program::compile(source, {}, "<socket>");
+    *cached = false;
+
+    lock_guard<mutex> guard(cacheLock);
+
+    // Replace any entry with the same hash, then evict the least
+    // recently used entries while the cache is over capacity.
+    auto found = cache.find(hash);
+    if (found != cache.end())
+    {
+        recentlyUsed.erase(found->second.recent);
+        cache.erase(found);
+    }
+
+    recentlyUsed.push_front(hash);
+    cache.emplace(hash, CacheEntry{source, program, recentlyUsed.begin()});
+
+    while (cache.size() > cacheCapacity)
+    {
+        cache.erase(recentlyUsed.back());
+        recentlyUsed.pop_back();
+    }
+
+    return program;
+}
@@ -0,0 +1,95 @@
+/**
+ * Interpreter daemon for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "Program.h"
+
+using namespace std;
+
+/**
+ * A long-lived process that accepts program source over a UNIX domain
+ * socket, compiles and runs it, and streams the output back.
+ *
+ * The protocol: a client connects, writes the program source, and
+ * shuts down its side of the connection for writing. The server
+ * writes back everything the program would have written to stdout,
+ * including any error messages, and closes the connection.
+ *
+ * Compiled programs are cached by a hash of their source, so a
+ * resubmitted program is executed without being scanned or parsed.
+ * Each connection is served on its own thread, up to a limit on the
+ * connections at once, and a client that sends too much source or
+ * stalls is cut off. A cached parse tree
+ * is never modified, so several threads can run it at once, each
+ * with its own execution context.
+ */
+class ProgramServer
+{
+public:
+    /**
+     * Constructor.
+     * @param socketPath the path of the socket to listen on.
+     * @param cacheCapacity the most compiled programs to keep.
+     */
+    ProgramServer(const string &socketPath, size_t cacheCapacity = 256)
+        : socketPath(socketPath), cacheCapacity(cacheCapacity),
+          connectionCount(0) {}
+
+    /**
+     * Accept and serve connections until the process is killed.
+     * @return false if the socket couldn't be set up.
+     */
+    bool serve();
+
+private:
+    /**
+     * A cached program.
+     */
+    struct CacheEntry
+    {
+        string source;    // to rule out hash collisions
+        Program program;
+        list<uint64_t>::iterator recent;  // position in recentlyUsed
+    };
+
+    // Limits that keep clients from tying up the server's threads
+    // and memory: connections served at once, the largest source
+    // accepted, and how long to wait for more of it or for a client
+    // to take its output.
+    static const int    MAX_CONNECTIONS = 64;
+    static const size_t MAX_SOURCE_SIZE = 16*1024*1024;
+    static const int    SOCKET_TIMEOUT_SECONDS = 10;
+
+    string socketPath;
+    size_t cacheCapacity;
+
+    // The number of connections being served.
+    mutex connectionLock;
+    condition_variable connectionDone;
+    int connectionCount;
+
+    // The cache, with its entries' hashes in least recently used order.
+    mutex cacheLock;
+    list<uint64_t> recentlyUsed;
+    unordered_map<uint64_t, CacheEntry> cache;
+
+    void handle(int client);
+    void serve(int client);
+    Program compile(const string &source, bool *cached);
+};
+
+#endif /* SERVER_H_ */
@@ -7,119 +7,899 @@
  * San Jose State University
  */
 #include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
 
 #include "frontend/Source.h"
 #include "frontend/Scanner.h"
 #include "frontend/Parser.h"
+#include "frontend/ParallelParser.h"
 #include "frontend/Token.h"
 #include "intermediate/ParseTreePrinter.h"
 #include "backend/Executor.h"
+#include "Output.h"
+#include "Timing.h"
+#include "WorkStealingPool.h"
+#include "Server.h"
+#include "ForkServer.h"
+#include "Repl.h"
+#include "Watcher.h"
+#include "OutputCache.h"
+#include "AstCache.h"
+#include "backend/FlatExecutor.h"
+#include "backend/CodeGenerator.h"
+#include "backend/VirtualMachine.h"
+#include "MappedFile.h"
 
 using namespace std;
 using namespace frontend;
 using namespace intermediate;
 using namespace backend;
 
-void testScanner(Source *source);
-void testParser(Scanner *scanner, Symtab *symtab);
-void executeProgram(Parser *parser, Symtab *symtab);
+/**
+ * How a program run ended.
+ */
+enum class RunStatus { OK, SYNTAX_ERRORS, RUNTIME_ERROR, SOURCE_ERROR };
+
+// -cache: where to replay the outputs of unchanged programs from.
+OutputCache *outputCache = nullptr;
+
+// -astcache: where to map the compiled trees of unchanged programs from.
+AstCache *astCache = nullptr;
+
+// -pipeline: scan on a thread of its own while parsing.
+bool pipelined = false;
+
+// -jobs N for a single program: parse on N threads.
+int parseJobs = 1;
+
+void testScanner(const string &sourceFileName, PhaseTimer *timer);
+void testParser(const string &sourceFileName, PhaseTimer *timer);
+RunStatus executeProgram(const string &sourceFileName, PhaseTimer *timer);
+RunStatus compileAndExecute(Source *source, PhaseTimer *timer);
+RunStatus streamProgram(const string &sourceFileName, PhaseTimer *timer);
+RunStatus executeFlatTree(const FlatTree *tree, PhaseTimer *timer);
+RunStatus compileImage(const string &sourceFileName,
+                       const string &imageFileName, PhaseTimer *timer);
+RunStatus runImage(const string &imageFileName, PhaseTimer *timer);
+RunStatus runBatchProgram(const string &sourceFileName, PhaseTimer *timer);
+int runBatch(const vector<string> &sourceFileNames, bool timing);
+int runParallelBatch(const vector<string> &sourceFileNames, bool timing,
+                     int jobs);
+void reportBatchProgram(const string &sourceFileName, RunStatus status,
+                        PhaseTimer *timer, bool timing, double *totalMs);
+vector<string> readBatchList(const string &listFileName);
+void beginPhase(PhaseTimer *timer, const char *name);
+void startScanning(Scanner *scanner, PhaseTimer *timer);
+Node *parseSource(Source *source, Symtab *symtab, PhaseTimer *timer,
+                  int *errorCount);
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    bool timing = false;  // -time: report each phase's time and memory
+    int jobs = 1;         // -jobs N: run a batch on N threads
+    int limit = ForkServer::DEFAULT_CPU_LIMIT;  // -limit S: a job's CPU seconds
+    string cacheDirectory;         // -cache DIR: the output cache
+    string astCacheDirectory;      // -astcache DIR: the tree cache
+    long cacheLimitMb = 64;        // -cachelimit MB: its size limit
+    int first = 1;
+
+    for (bool more = true; more && (first < argc); )
     {
-        cout << "Usage: simple -{scan, parse, execute} sourceFileName" << endl;
+        string option = argv[first];
+
+        if (option == "-time")
+        {
+            timing = true;
+            first++;
+        }
+        else if (option == "-pipeline")
+        {
+            pipelined = true;
+            first++;
+        }
+        else if ((option == "-jobs") && (first + 1 < argc))
+        {
+            jobs = atoi(argv[first + 1]);
+            first += 2;
+        }
+        else if ((option == "-limit") && (first + 1 < argc))
+        {
+            limit = atoi(argv[first + 1]);
+            first += 2;
+        }
+        else if ((option == "-cache") && (first + 1 < argc))
+        {
+            cacheDirectory = argv[first + 1];
+            first += 2;
+        }
+        else if ((option == "-astcache") && (first + 1 < argc))
+        {
+            astCacheDirectory = argv[first + 1];
+            first += 2;
+        }
+        else if ((option == "-cachelimit") && (first + 1 < argc))
+        {
+            cacheLimitMb = atol(argv[first + 1]);
+            first += 2;
+        }
+        else more = false;
+    }
+
+    // -batch takes either a file that lists the programs to run,
+    // or else two or more program file names.
+    bool batch = (argc - first >= 2) && (string(argv[first]) == "-batch");
+
+    // -forkserver takes the names of any programs to preload.
+    bool forkServer =    (argc - first >= 1)
+                      && (string(argv[first]) == "-forkserver");
+
+    // -repl takes no file name.
+    bool repl = (argc - first == 1) && (string(argv[first]) == "-repl");
+
+    // -compile takes a source file name and -o imageFileName.
+    bool compile =    (argc - first == 4) && (string(argv[first]) == "-compile")
+                   && (string(argv[first + 2]) == "-o");
+
+    if (   (!batch && !forkServer && !repl && !compile && (argc - first != 2))
+        || (jobs < 1) || (limit < 0) || (cacheLimitMb < 0))
+    {
+        cout << "Usage: simple [-time] [-pipeline] [-jobs N] "
+             << "-{scan, parse, execute, stream} sourceFileName"
+             << endl
+             << "       simple [-time] [-pipeline] [-cache dir] "
+             << "[-astcache dir] [-cachelimit MB]"
+             << endl
+             << "              -execute sourceFileName"
+             << endl
+             << "       simple [-time] [-jobs N] [-cache dir] [-astcache dir] "
+             << "[-cachelimit MB]"
+             << endl
+             << "              -batch "
+             << "{listFileName | sourceFileName...}"
+             << endl
+             << "       simple -serve socketPath"
+             << endl
+             << "       simple [-limit seconds] -forkserver "
+             << "[sourceFileName...]"
+             << endl
+             << "       simple -repl"
+             << endl
+             << "       simple -watch sourceFileName"
+             << endl
+             << "       simple [-time] [-pipeline] -compile sourceFileName "
+             << "-o imageFileName"
+             << endl
+             << "       simple [-time] -run imageFileName"
+             << endl;
         exit(-1);
     }
 
-    Token::initialize();
-    Parser::initialize();
-    Executor::initialize();
+    string operation = argv[first];
+    if (!batch) parseJobs = jobs;
+
+    if (!cacheDirectory.empty())
+    {
+        outputCache = new OutputCache(cacheDirectory,
+                                      (uint64_t) cacheLimitMb << 20);
+    }
+
+    if (!astCacheDirectory.empty())
+    {
+        astCache = new AstCache(astCacheDirectory,
+                                (uint64_t) cacheLimitMb << 20);
+    }
+
+    if (batch)
+    {
+        vector<string> sourceFileNames(argv + first + 1, argv + argc);
 
-    string operation      = argv[1];
-    string sourceFileName = argv[2];
+        try
+        {
+            if (sourceFileNames.size() == 1)
+            {
+                sourceFileNames = readBatchList(sourceFileNames[0]);
+            }
+        }
+        catch (SourceError &error)
+        {
+            cout << error.what() << endl;
+            exit(-1);
+        }
 
-    Source *source = new Source(sourceFileName);
+        return jobs > 1 ? runParallelBatch(sourceFileNames, timing, jobs)
+                        : runBatch(sourceFileNames, timing);
+    }
 
-    if (operation == "-scan")
+    if (repl)
     {
-        testScanner(source);
+        Repl session;
+        return session.run(stdin, isatty(fileno(stdin)));
     }
-    else if (operation == "-parse")
+
+    if (forkServer)
     {
-        testParser(new Scanner(source), new Symtab());
+        ForkServer server(limit);
+        for (int i = first + 1; i < argc; i++)
+        {
+            if (!server.preload(argv[i])) exit(-1);
+        }
+
+        return server.serve(stdin);
     }
-    else if (operation == "-execute")
+
+    if (operation == "-watch")
     {
-        Symtab *symtab = new Symtab();
-        executeProgram(new Parser(new Scanner(source), symtab), symtab);
+        Watcher watcher(argv[first + 1]);
+        return watcher.watch();
     }
 
-    return 0;
+    if (operation == "-serve")
+    {
+        ProgramServer server(argv[first + 1]);
+        return server.serve() ? 0 : -1;
+    }
+
+    string sourceFileName = argv[first + 1];
+    PhaseTimer *timer = timing ? new PhaseTimer() : nullptr;
+    RunStatus status = RunStatus::OK;
+
+    try
+    {
+        if      (operation == "-scan")    testScanner(sourceFileName, timer);
+        else if (operation == "-parse")   testParser(sourceFileName, timer);
+        else if (operation == "-execute")
+        {
+            status = executeProgram(sourceFileName, timer);
+        }
+        else if (operation == "-stream")
+        {
+            status = streamProgram(sourceFileName, timer);
+        }
+        else if (operation == "-compile")
+        {
+            status = compileImage(sourceFileName, argv[first + 3], timer);
+        }
+        else if (operation == "-run")
+        {
+            status = runImage(sourceFileName, timer);
+        }
+    }
+    catch (SourceError &error)
+    {
+        cout << error.what() << endl;
+        exit(-1);
+    }
+
+    if (timer != nullptr)
+    {
+        timer->end();
+        fflush(stdout);
+        timer->report(stderr);
+    }
+
+    // A deployment must not ship a program that didn't compile.
+    if ((operation == "-compile") && (status != RunStatus::OK)) return -1;
+
+    return status == RunStatus::RUNTIME_ERROR ? -2 : 0;
+}
+
+/**
+ * Start timing a phase if timing is on.
+ * @param timer the phase timer, or null if timing is off.
+ * @param name the phase's name.
+ */
+void beginPhase(PhaseTimer *timer, const char *name)
+{
+    if (timer != nullptr) timer->begin(name);
+}
+
+/**
+ * Get a scanner ready for the parser. When timing, scan everything
+ * first so that scanning and parsing are measured separately, unless
+ * the scanner is to run concurrently with the parser.
+ * @param scanner the scanner.
+ * @param timer the phase timer, or null if timing is off.
+ */
+void startScanning(Scanner *scanner, PhaseTimer *timer)
+{
+    if (pipelined) scanner->pipeline();
+    else if (timer != nullptr)
+    {
+        beginPhase(timer, "scanning");
+        scanner->scanAll();
+    }
+}
+
+/**
+ * Parse a program, in parallel if there are parse jobs and the
+ * program can be, or else sequentially.
+ * @param source the program's source.
+ * @param symtab the symbol table to fill in.
+ * @param timer the phase timer, or null if timing is off.
+ * @param errorCount set to the count of syntax and semantic errors.
+ * @return the root of the parse tree.
+ */
+Node *parseSource(Source *source, Symtab *symtab, PhaseTimer *timer,
+                  int *errorCount)
+{
+    *errorCount = 0;
+
+    if (parseJobs > 1)
+    {
+        beginPhase(timer, "parsing");
+        ParallelParser parallelParser(parseJobs);
+        Node *programNode = parallelParser.parseProgram(
+                                        source->getText(), source->getName(),
+                                        symtab, source->getConstantPool());
+        if (programNode != nullptr) return programNode;
+    }
+
+    Scanner scanner(source);
+    startScanning(&scanner, timer);
+
+    beginPhase(timer, "parsing");
+    Parser parser(&scanner, symtab);
+    Node *programNode = parser.parseProgram();
+    *errorCount = parser.getErrorCount();
+
+    return programNode;
 }
 
 /**
  * Test the scanner.
- * @param source the input source.
+ * @param sourceFileName the source file name.
+ * @param timer the phase timer, or null if timing is off.
  */
-void testScanner(Source *source)
+void testScanner(const string &sourceFileName, PhaseTimer *timer)
 {
-    cout << "Tokens:" << endl << endl;
+    beginPhase(timer, "source open");
+    ConstantPool constants;  // this run's string literals
+    Source source(sourceFileName);
+    source.setConstantPool(&constants);
+    Scanner scanner(&source);  // create the scanner
 
-    Scanner *scanner = new Scanner(source);  // create the scanner
+    // When timing, scan everything first so that scanning
+    // and printing are measured separately.
+    if (timer != nullptr)
+    {
+        beginPhase(timer, "scanning");
+        scanner.scanAll();
+        beginPhase(timer, "printing");
+    }
+
+    cout << "Tokens:" << endl << endl;
 
     // Loop to extract and print each token from the source one at a time.
-    for (Token *token = scanner->nextToken();
-         token->type != END_OF_FILE;
-         token = scanner->nextToken())
+    Token *token;
+    while ((token = scanner.nextToken())->type != END_OF_FILE)
     {
         printf("%14s : %s\n",
-               TOKEN_TYPE_STRINGS[(int) token->type].c_str(),
+               TOKEN_TYPE_STRINGS[(int) token->type],
                token->text.c_str());
+        delete token;
     }
+
+    delete token;
 }
 
 /**
  * Test the parser.
- * @param scanner the scanner.
- * @param symtab the symbol table.
+ * @param sourceFileName the source file name.
+ * @param timer the phase timer, or null if timing is off.
  */
-void testParser(Scanner *scanner, Symtab *symtab)
+void testParser(const string &sourceFileName, PhaseTimer *timer)
 {
-    Parser *parser = new Parser(scanner, symtab);  // create the parser
-    Node *programNode = parser->parseProgram();    // and parse the program
-    int errorCount = parser->getErrorCount();
+    beginPhase(timer, "source open");
+    ConstantPool constants;  // this run's string literals
+    Source source(sourceFileName);
+    source.setConstantPool(&constants);
+    Symtab symtab;
+
+    int errorCount;
+    Node *programNode = parseSource(&source, &symtab, timer, &errorCount);
 
     if (errorCount == 0)
     {
+        beginPhase(timer, "printing");
         cout << "Parse tree:" << endl << endl;
 
-        ParseTreePrinter *printer = new ParseTreePrinter();
-        printer->print(programNode);
+        ParseTreePrinter printer;
+        printer.print(programNode);
     }
     else
     {
         cout << endl << "There were " << errorCount << " errors." << endl;
     }
+
+    delete programNode;
+}
+
+/**
+ * Compile and execute a program, then free everything it used.
+ * A runtime error stops only this program. With an output cache,
+ * replay the output of an earlier run of the same source instead,
+ * or else save this run's output for next time. With a tree cache,
+ * execute the mapped tree of an earlier compilation of the same
+ * source instead of compiling it again.
+ * @param sourceFileName the source file name.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the run ended.
+ * @throw SourceError if the source file can't be read.
+ */
+RunStatus executeProgram(const string &sourceFileName, PhaseTimer *timer)
+{
+    beginPhase(timer, "source open");
+    ConstantPool constants;  // this run's string literals
+    Source source(sourceFileName);
+    source.setConstantPool(&constants);
+
+    if (outputCache != nullptr)
+    {
+        beginPhase(timer, "cache lookup");
+
+        int cachedStatus;
+        if (outputCache->lookup(source.getText(), output(), &cachedStatus))
+        {
+            return (RunStatus) cachedStatus;
+        }
+    }
+
+    // Keep a copy of the output for the cache.
+    TeeSink copy(&output());
+    OutputRedirect redirect(outputCache != nullptr ? &copy : &output());
+
+    AstCache::Mapping *mapping = nullptr;
+    if (astCache != nullptr)
+    {
+        beginPhase(timer, "tree lookup");
+        mapping = astCache->lookup(source.getText());
+    }
+
+    RunStatus status;
+    if (mapping != nullptr)
+    {
+        status = executeFlatTree(mapping->getTree(), timer);
+        delete mapping;
+    }
+    else status = compileAndExecute(&source, timer);
+
+    if (outputCache != nullptr)
+    {
+        beginPhase(timer, "cache store");
+        outputCache->store(source.getText(), copy.getText(), (int) status);
+    }
+
+    return status;
 }
 
 /**
- * Test the executor.
- * @param parser the parser.
- * @param symtab the symbol table.
+ * Compile and execute a program, then free its parse tree.
+ * With a tree cache, save the tree for next time.
+ * @param source the program's source.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the run ended.
  */
-void executeProgram(Parser *parser, Symtab *symtab)
+RunStatus compileAndExecute(Source *source, PhaseTimer *timer)
 {
-    Node *programNode = parser->parseProgram();
-    int errorCount = parser->getErrorCount();
+    Symtab symtab;
+
+    int errorCount;
+    Node *programNode = parseSource(source, &symtab, timer, &errorCount);
+    RunStatus status = RunStatus::OK;
 
     if (errorCount == 0)
     {
-        Executor *executor = new Executor();
-        executor->visit(programNode);
+        if (astCache != nullptr)
+        {
+            beginPhase(timer, "tree store");
+            astCache->store(source->getText(), programNode,
+                            symtab.getSlotNames());
+        }
+
+        beginPhase(timer, "execution");
+        Context context(symtab.size());
+        Executor executor(&context);
+
+        try
+        {
+            executor.visit(programNode);
+        }
+        catch (RuntimeError &error)
+        {
+            output().print("%s\n", error.what());
+            status = RunStatus::RUNTIME_ERROR;
+        }
     }
     else
     {
-        cout << endl << "There were " << errorCount << " errors." << endl;
+        output().print("\nThere were %d errors.\n", errorCount);
+        status = RunStatus::SYNTAX_ERRORS;
+    }
+
+    beginPhase(timer, "cleanup");
+    delete programNode;
+
+    return status;
+}
+
+/**
+ * Execute each top-level statement of a program as soon as it's
+ * parsed, then free it, so that memory stays bounded however long
+ * the program is and output starts right away. Execution stops at the
+ * first syntax error, although parsing goes on to report all of them,
+ * and a runtime error stops both.
+ * @param sourceFileName the source file name.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the run ended.
+ * @throw SourceError if the source file can't be read.
+ */
+RunStatus streamProgram(const string &sourceFileName, PhaseTimer *timer)
+{
+    beginPhase(timer, "source open");
+    ConstantPool constants;  // this run's string literals
+    Source source(sourceFileName);
+    source.setConstantPool(&constants);
+    Scanner scanner(&source);
+    Symtab symtab;
+    Context context(0);
+    RunStatus status = RunStatus::OK;
+
+    if (pipelined) scanner.pipeline();
+
+    beginPhase(timer, "streaming");
+    Parser parser(&scanner, &symtab);
+    Node *programNode = parser.parseProgram(
+        [&](Node *statementNode)
+        {
+            if (parser.getErrorCount() == 0)
+            {
+                // The statement may have entered new variables.
+                context.values.resize(symtab.size(), 0.0);
+                Executor executor(&context);
+
+                try
+                {
+                    executor.visit(statementNode);
+                }
+                catch (RuntimeError &error)
+                {
+                    output().print("%s\n", error.what());
+                    status = RunStatus::RUNTIME_ERROR;
+                }
+            }
+
+            delete statementNode;
+            return status == RunStatus::OK;
+        });
+
+    int errorCount = parser.getErrorCount();
+    if ((status == RunStatus::OK) && (errorCount > 0))
+    {
+        output().print("\nThere were %d errors.\n", errorCount);
+        status = RunStatus::SYNTAX_ERRORS;
     }
+
+    beginPhase(timer, "cleanup");
+    delete programNode;
+
+    return status;
+}
+
+/**
+ * Execute a compiled program in the flat format.
+ * @param tree the flat tree.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the run ended.
+ */
+RunStatus executeFlatTree(const FlatTree *tree, PhaseTimer *timer)
+{
+    beginPhase(timer, "execution");
+    Context context(tree->getSlotCount());
+    FlatExecutor executor(tree, &context);
+
+    try
+    {
+        executor.execute();
+    }
+    catch (RuntimeError &error)
+    {
+        output().print("%s\n", error.what());
+        return RunStatus::RUNTIME_ERROR;
+    }
+
+    return RunStatus::OK;
+}
+
+/**
+ * Compile a program into a bytecode image file.
+ * @param sourceFileName the source file name.
+ * @param imageFileName the image file name.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the compilation ended.
+ * @throw SourceError if the source file can't be read
+ *                    or the image file can't be written.
+ */
+RunStatus compileImage(const string &sourceFileName,
+                       const string &imageFileName, PhaseTimer *timer)
+{
+    beginPhase(timer, "source open");
+    ConstantPool constants;  // this run's string literals
+    Source source(sourceFileName);
+    source.setConstantPool(&constants);
+    Symtab symtab;
+
+    int errorCount;
+    Node *programNode = parseSource(&source, &symtab, timer, &errorCount);
+
+    if (errorCount > 0)
+    {
+        output().print("\nThere were %d errors.\n", errorCount);
+        delete programNode;
+
+        return RunStatus::SYNTAX_ERRORS;
+    }
+
+    beginPhase(timer, "code gen");
+    string image = CodeGenerator::generate(programNode,
+                                           symtab.getSlotNames());
+    delete programNode;
+
+    // Write a temporary file and rename it, so that a host
+    // never sees a partly written image.
+    beginPhase(timer, "image write");
+    string tempFileName = imageFileName + ".tmp";
+    FILE *file = fopen(tempFileName.c_str(), "wb");
+    bool written =    (file != nullptr)
+                   && (fwrite(image.data(), 1, image.size(), file)
+                           == image.size());
+
+    if ((file == nullptr) || (fclose(file) != 0) || !written
+        || (rename(tempFileName.c_str(), imageFileName.c_str()) != 0))
+    {
+        unlink(tempFileName.c_str());
+        throw SourceError("*** ERROR: Failed to write " + imageFileName);
+    }
+
+    return RunStatus::OK;
+}
+
+/**
+ * Run a program from its bytecode image file, without its source.
+ * @param imageFileName the image file name.
+ * @param timer the phase timer, or null if timing is off.
+ * @return how the run ended.
+ * @throw SourceError if the image file can't be read or isn't valid.
+ */
+RunStatus runImage(const string &imageFileName, PhaseTimer *timer)
+{
+    beginPhase(timer, "image load");
+    MappedFile file(imageFileName);
+    if (!file.isMapped())
+    {
+        throw SourceError("*** ERROR: Failed to open " + imageFileName);
+    }
+
+    BytecodeImage image(file.getContents());
+    if (image.getProblem() != nullptr)
+    {
+        throw SourceError("*** ERROR: " + imageFileName + ": "
+                          + image.getProblem());
+    }
+
+    beginPhase(timer, "execution");
+    Context context(image.getSlotCount());
+    VirtualMachine machine(&image, &context);
+
+    try
+    {
+        machine.execute();
+    }
+    catch (RuntimeError &error)
+    {
+        output().print("%s\n", error.what());
+        return RunStatus::RUNTIME_ERROR;
+    }
+
+    return RunStatus::OK;
+}
+
+/**
+ * Read the list of programs for a batch: one source file name per line.
+ * Blank lines and lines that start with # are ignored.
+ * @param listFileName the name of the list file.
+ * @return the source file names.
+ * @throw SourceError if the list file can't be opened.
+ */
+vector<string> readBatchList(const string &listFileName)
+{
+    ifstream list(listFileName);
+    if (list.fail())
+    {
+        throw SourceError("*** ERROR: Failed to open " + listFileName);
+    }
+
+    vector<string> sourceFileNames;
+    string line;
+
+    while (getline(list, line))
+    {
+        size_t first = line.find_first_not_of(" \t\r");
+        if ((first == string::npos) || (line[first] == '#')) continue;
+
+        size_t last = line.find_last_not_of(" \t\r");
+        sourceFileNames.push_back(line.substr(first, last - first + 1));
+    }
+
+    return sourceFileNames;
+}
+
+/**
+ * Compile and execute one program of a batch. A source error
+ * is reported like any other error and doesn't stop the batch.
+ * @param sourceFileName the source file name.
+ * @param timer the program's phase timer.
+ * @return how the run ended.
+ */
+RunStatus runBatchProgram(const string &sourceFileName, PhaseTimer *timer)
+{
+    RunStatus status;
+
+    try
+    {
+        status = executeProgram(sourceFileName, timer);
+    }
+    catch (SourceError &error)
+    {
+        output().print("%s\n", error.what());
+        status = RunStatus::SOURCE_ERROR;
+    }
+
+    timer->end();
+    return status;
+}
+
+/**
+ * Report a batch program's status and phase times on stderr.
+ * @param sourceFileName the program's source file name.
+ * @param status how its run ended.
+ * @param timer its phase timer.
+ * @param timing true to also print its full phase table.
+ * @param totalMs the batch's total time so far, to add the program's to.
+ */
+void reportBatchProgram(const string &sourceFileName, RunStatus status,
+                        PhaseTimer *timer, bool timing, double *totalMs)
+{
+    static const char *STATUS_STRINGS[] =
+    {
+        "ok", "syntax errors", "runtime error", "source error"
+    };
+
+    double programMs = 0.0;
+    string phases;
+    for (const PhaseTimer::Phase &phase : timer->getPhases())
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%s%s %.3f",
+                 phases.empty() ? "" : ", ",
+                 phase.name.c_str(), phase.wallMs);
+
+        phases += buffer;
+        programMs += phase.wallMs;
+    }
+
+    fprintf(stderr, "batch: %s: %s, %.3f ms (%s)\n",
+            sourceFileName.c_str(), STATUS_STRINGS[(int) status],
+            programMs, phases.c_str());
+    if (timing) timer->report(stderr);
+
+    *totalMs += programMs;
+}
+
+/**
+ * Compile and execute a batch of programs one after another in this
+ * process. Each program's output goes to stdout in turn. A line with
+ * each program's status and phase times goes to stderr.
+ * @param sourceFileNames the programs' source file names.
+ * @param timing true to also print each program's full phase table.
+ * @return 0 if every program ran cleanly, else 1.
+ */
+int runBatch(const vector<string> &sourceFileNames, bool timing)
+{
+    int failures = 0;
+    double totalMs = 0.0;
+
+    for (const string &sourceFileName : sourceFileNames)
+    {
+        PhaseTimer timer;
+        RunStatus status = runBatchProgram(sourceFileName, &timer);
+        fflush(stdout);
+
+        if (status != RunStatus::OK) failures++;
+        reportBatchProgram(sourceFileName, status, &timer, timing, &totalMs);
+    }
+
+    fprintf(stderr, "batch: %zu programs, %d failed, %.3f ms\n",
+            sourceFileNames.size(), failures, totalMs);
+
+    return failures == 0 ? 0 : 1;
+}
+
+/**
+ * Compile and execute a batch of programs concurrently on a
+ * work-stealing pool of threads. Each program runs with its own
+ * scanner, parser, symbol table, and execution context, and its
+ * output is captured. The captured outputs and the stderr reports
+ * are emitted in input order as soon as each program and all the
+ * ones before it have finished, so the results are the same as
+ * for a sequential batch.
+ * @param sourceFileNames the programs' source file names.
+ * @param timing true to also print each program's full phase table.
+ * @param jobs the number of threads.
+ * @return 0 if every program ran cleanly, else 1.
+ */
+int runParallelBatch(const vector<string> &sourceFileNames, bool timing,
+                     int jobs)
+{
+    struct Result
+    {
+        StringSink output;
+        PhaseTimer timer;
+        RunStatus status;
+        bool done = false;
+    };
+
+    size_t count = sourceFileNames.size();
+    vector<Result> results(count);
+    mutex resultsLock;
+    condition_variable finished;
+
+    WorkStealingPool pool(jobs);
+    thread runner([&]()
+    {
+        pool.run(count, [&](size_t i)
+        {
+            Result &result = results[i];
+            {
+                OutputRedirect redirect(&result.output);
+                result.status = runBatchProgram(sourceFileNames[i],
+                                                &result.timer);
+            }
+
+            lock_guard<mutex> guard(resultsLock);
+            result.done = true;
+            finished.notify_one();
+        });
+    });
+
+    int failures = 0;
+    double totalMs = 0.0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Result &result = results[i];
+        {
+            unique_lock<mutex> guard(resultsLock);
+            finished.wait(guard, [&result]() { return result.done; });
+        }
+
+        const string &text = result.output.getText();
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+
+        if (result.status != RunStatus::OK) failures++;
+        reportBatchProgram(sourceFileNames[i], result.status, &result.timer,
+                           timing, &totalMs);
+    }
+
+    runner.join();
+
+    fprintf(stderr, "batch: %zu programs, %d failed, %.3f ms\n",
+            count, failures, totalMs);
+
+    return failures == 0 ? 0 : 1;
 }
@@ -0,0 +1,144 @@
+/**
+ * Single-producer single-consumer queue for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * A bounded queue between exactly one producer thread and one
+ * consumer thread. It's a ring buffer whose two indices are atomics,
+ * so neither side takes a lock while the queue is neither full nor
+ * empty. A side that must wait sleeps on a condition variable, and
+ * the other side takes the lock to wake it only if it's waiting.
+ */
+template <class T>
+class SpscQueue
+{
+public:
+    /**
+     * Constructor.
+     * @param capacity the most items the queue holds at once.
+     */
+    SpscQueue(size_t capacity)
+        : slots(capacity), head(0), tail(0), closed(false),
+          producerWaiting(false), consumerWaiting(false) {}
+
+    /**
+     * Append an item, waiting while the queue is full.
+     * Called only by the producer.
+     * @param item the item.
+     * @return true if appended, false if the queue was closed.
+     */
+    bool push(T &&item)
+    {
+        size_t t = tail.load(memory_order_relaxed);
+
+        while (t - head.load(memory_order_acquire) == slots.size())
+        {
+            if (!wait(producerWaiting, notFull,
+                      [&] { return t - head.load() < slots.size(); }))
+            {
+                return false;
+            }
+        }
+
+        slots[t%slots.size()] = move(item);
+        tail.store(t + 1);
+        wake(consumerWaiting, notEmpty);
+
+        return true;
+    }
+
+    /**
+     * Remove the oldest item, waiting while the queue is empty.
+     * Called only by the consumer.
+     * @param item set to the item.
+     * @return true if removed, false if the queue was closed.
+     */
+    bool pop(T &item)
+    {
+        size_t h = head.load(memory_order_relaxed);
+
+        while (h == tail.load(memory_order_acquire))
+        {
+            if (!wait(consumerWaiting, notEmpty,
+                      [&] { return h != tail.load(); }))
+            {
+                return false;
+            }
+        }
+
+        item = move(slots[h%slots.size()]);
+        head.store(h + 1);
+        wake(producerWaiting, notFull);
+
+        return true;
+    }
+
+    /**
+     * Close the queue: wake both sides and make every later
+     * push() or pop() that would wait return false instead.
+     */
+    void close()
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    vector<T> slots;
+    atomic<size_t> head;  // the count of items ever removed
+    atomic<size_t> tail;  // the count of items ever appended
+    mutex lock;
+    condition_variable notFull;
+    condition_variable notEmpty;
+    bool closed;
+    atomic<bool> producerWaiting;
+    atomic<bool> consumerWaiting;
+
+    /**
+     * Sleep until a condition holds. The waiting flag is set before
+     * the condition is checked again, and the other side checks the
+     * flag after it changes the condition, so a wakeup can't be lost.
+     * @param waiting this side's waiting flag.
+     * @param wakeup the condition variable to sleep on.
+     * @param ready the condition.
+     * @return true if the condition holds, false if the queue was closed.
+     */
+    template <class Predicate>
+    bool wait(atomic<bool> &waiting, condition_variable &wakeup,
+              Predicate ready)
+    {
+        unique_lock<mutex> guard(lock);
+        waiting.store(true);
+
+        while (!ready() && !closed) wakeup.wait(guard);
+
+        waiting.store(false);
+        return ready();
+    }
+
+    void wake(atomic<bool> &waiting, condition_variable &wakeup)
+    {
+        if (waiting.load())
+        {
+            lock_guard<mutex> guard(lock);
+            wakeup.notify_one();
+        }
+    }
+};
+
+#endif /* SPSCQUEUE_H_ */
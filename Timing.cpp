@@ -0,0 +1,98 @@
+/**
+ * Phase timing and memory statistics for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <algorithm>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "MemoryCounters.h"
+#include "Timing.h"
+
+using namespace std;
+
+/**
+ * @return the CPU time used by the calling thread so far, in milliseconds.
+ */
+static double cpuMilliseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return ts.tv_sec*1000.0 + ts.tv_nsec/1000000.0;
+}
+
+/**
+ * @return the peak resident set size of the process so far, in KB.
+ */
+static long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;  // Linux reports kilobytes
+}
+
+void PhaseTimer::begin(const string &name)
+{
+    if (running) end();
+
+    phases.push_back(Phase{name, 0.0, 0.0, 0, 0, 0, 0});
+    running = true;
+
+    countsStart = MemoryCounters::forThread();
+    cpuStart    = cpuMilliseconds();
+    wallStart   = chrono::steady_clock::now();
+}
+
+void PhaseTimer::end()
+{
+    if (!running) return;
+
+    chrono::steady_clock::time_point wallEnd = chrono::steady_clock::now();
+    double cpuEnd = cpuMilliseconds();
+
+    Phase &phase = phases.back();
+    phase.wallMs      = chrono::duration<double, milli>(wallEnd - wallStart)
+                                                                    .count();
+    phase.cpuMs       = cpuEnd - cpuStart;
+    MemoryCounters counts = MemoryCounters::forThread().since(countsStart);
+    phase.allocations = counts.allocations;
+    phase.bytes       = counts.bytes;
+    phase.sharedNodes = counts.sharedNodes;
+    phase.peakRssKb   = peakRssKb();
+
+    running = false;
+}
+
+void PhaseTimer::report(FILE *out) const
+{
+    Phase total{"total", 0.0, 0.0, 0, 0, 0, 0};
+
+    fprintf(out, "\n%-12s %12s %12s %12s %14s %12s %12s\n",
+            "Phase", "Wall ms", "CPU ms", "Allocs", "Bytes", "Shared nodes",
+            "Peak RSS KB");
+
+    for (const Phase &phase : phases)
+    {
+        fprintf(out, "%-12s %12.3f %12.3f %12ld %14ld %12ld %12ld\n",
+                phase.name.c_str(), phase.wallMs, phase.cpuMs,
+                phase.allocations, phase.bytes, phase.sharedNodes,
+                phase.peakRssKb);
+
+        total.wallMs      += phase.wallMs;
+        total.cpuMs       += phase.cpuMs;
+        total.allocations += phase.allocations;
+        total.bytes       += phase.bytes;
+        total.sharedNodes += phase.sharedNodes;
+        total.peakRssKb    = max(total.peakRssKb, phase.peakRssKb);
+    }
+
+    fprintf(out, "%-12s %12.3f %12.3f %12ld %14ld %12ld %12ld\n",
+            total.name.c_str(), total.wallMs, total.cpuMs,
+            total.allocations, total.bytes, total.sharedNodes,
+            total.peakRssKb);
+}
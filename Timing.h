@@ -0,0 +1,76 @@
+/**
+ * Phase timing and memory statistics for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+
+#include "MemoryCounters.h"
+
+using namespace std;
+
+/**
+ * Records the wall time, CPU time, heap allocations, shared tree nodes,
+ * and peak resident set size of each phase of a run, e.g. scanning and
+ * parsing. CPU time, allocations, and sharing are those of the thread
+ * that runs the phase, as kept by MemoryCounters; peak resident set
+ * size is the whole process's.
+ */
+class PhaseTimer
+{
+public:
+    struct Phase
+    {
+        string name;
+        double wallMs;      // elapsed real time
+        double cpuMs;       // user + system time of the thread
+        long   allocations; // heap allocations made during the phase
+        long   bytes;       // bytes allocated during the phase
+        long   sharedNodes; // tree nodes shared instead of allocated
+        long   peakRssKb;   // peak resident set size at the phase's end
+    };
+
+    PhaseTimer() : running(false) {}
+
+    /**
+     * Start timing a phase. Ends any phase that's still running.
+     * @param name the phase's name.
+     */
+    void begin(const string &name);
+
+    /**
+     * Stop timing the current phase and record its statistics.
+     */
+    void end();
+
+    /**
+     * Getter.
+     * @return the phases recorded so far.
+     */
+    const vector<Phase> &getPhases() const { return phases; }
+
+    /**
+     * Print a table of the recorded phases and their total.
+     * @param out where to print, normally stderr.
+     */
+    void report(FILE *out) const;
+
+private:
+    vector<Phase> phases;
+    bool running;
+
+    // The state at the start of the current phase.
+    chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+    MemoryCounters countsStart;
+};
+
+#endif /* TIMING_H_ */
@@ -0,0 +1,534 @@
+/**
+ * Watch mode for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "frontend/Source.h"
+#include "frontend/Scanner.h"
+#include "frontend/Parser.h"
+#include "frontend/Token.h"
+#include "backend/Executor.h"
+#include "Hash.h"
+#include "Output.h"
+#include "Program.h"
+#include "Timing.h"
+#include "Watcher.h"
+
+using namespace std;
+using namespace frontend;
+using namespace backend;
+
+Watcher::~Watcher()
+{
+    for (auto &entry : cache)
+    {
+        for (Statement *statement : entry.second.statements)
+        {
+            for (Node *node : statement->nodes) delete node;
+            delete statement;
+        }
+    }
+}
+
+int Watcher::watch()
+{
+    // Watch the file's directory rather than the file itself, since
+    // many editors save by renaming a new file over the old one.
+    size_t slash = sourceFileName.rfind('/');
+    string directory = slash == string::npos
+                            ? "." : sourceFileName.substr(0, slash + 1);
+    string name = slash == string::npos
+                            ? sourceFileName : sourceFileName.substr(slash + 1);
+
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (   (fd < 0)
+        || (inotify_add_watch(fd, directory.c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0))
+    {
+        fprintf(stderr, "*** ERROR: Failed to watch %s: %s\n",
+                sourceFileName.c_str(), strerror(errno));
+        return -1;
+    }
+
+    rerun();
+
+    char events[4096]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+        ssize_t length = read(fd, events, sizeof(events));
+        if (length < 0)
+        {
+            if (errno == EINTR) continue;
+
+            fprintf(stderr, "*** ERROR: Failed to watch %s: %s\n",
+                    sourceFileName.c_str(), strerror(errno));
+            return -1;
+        }
+
+        bool changed = false;
+        for (char *p = events; p < events + length; )
+        {
+            inotify_event *event = (inotify_event *) p;
+            if ((event->len > 0) && (name == event->name)) changed = true;
+
+            p += sizeof(inotify_event) + event->len;
+        }
+
+        if (!changed) continue;
+
+        // Let the rest of the events from one save arrive.
+        pollfd waiting = { fd, POLLIN, 0 };
+        while (poll(&waiting, 1, 50) > 0)
+        {
+            if (read(fd, events, sizeof(events)) <= 0) break;
+        }
+
+        rerun();
+    }
+}
+
+/**
+ * Compile the program again, reusing what hasn't changed, and run it.
+ */
+void Watcher::rerun()
+{
+    PhaseTimer timer;
+    timer.begin("compile");
+
+    string text;
+    {
+        ifstream file(sourceFileName);
+        if (file.fail())
+        {
+            output().print("*** ERROR: Failed to open %s\n",
+                           sourceFileName.c_str());
+            fflush(stdout);
+            return;
+        }
+
+        stringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+    }
+
+    int parsedCount = 0;
+    int totalCount = 0;
+    Node *programNode = nullptr;
+
+    // Whatever goes wrong, the watcher must survive the edit.
+    // The full compile will report the problem.
+    try
+    {
+        programNode = compile(text, &parsedCount, &totalCount);
+    }
+    catch (const exception &)
+    {
+        programNode = nullptr;
+    }
+
+    if (programNode != nullptr)
+    {
+        timer.begin("execution");
+        Context context(slots.size());
+        Executor executor(&context);
+
+        try
+        {
+            executor.visit(programNode);
+        }
+        catch (RuntimeError &error)
+        {
+            output().print("%s\n", error.what());
+        }
+
+        // The statements themselves belong to the cache.
+        programNode->children[0]->children.clear();
+        delete programNode;
+    }
+    else
+    {
+        timer.begin("full compile and execution");
+        runFullCompile();
+    }
+
+    timer.end();
+
+    // Keep everything after an error, since the statements
+    // after the error weren't looked for.
+    endVersion(programNode != nullptr);
+    fflush(stdout);
+
+    string phases;
+    for (const PhaseTimer::Phase &phase : timer.getPhases())
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), ", %s %.3f ms",
+                 phase.name.c_str(), phase.wallMs);
+        phases += buffer;
+    }
+
+    fprintf(stderr, "watch: %s: parsed %d of %d statements%s\n",
+            sourceFileName.c_str(), parsedCount, totalCount, phases.c_str());
+}
+
+/**
+ * Compile a program from its top-level statements, reusing cached
+ * ones whose text hasn't changed.
+ * @param text the program's source text.
+ * @param parsedCount set to the number of statements that were parsed.
+ * @param totalCount set to the number of top-level statements.
+ * @return the PROGRAM node, or null if the program has any errors
+ *         or a shape this can't split. Its COMPOUND node's statements
+ *         belong to the cache.
+ */
+Node *Watcher::compile(const string &text, int *parsedCount, int *totalCount)
+{
+    struct Extent { size_t start, end; int firstLine; };
+
+    vector<Extent> extents;
+    string programName;
+    int beginLine = 0;
+
+    // Scan the whole text to find the extents of the main block's
+    // statements. Any token errors will be reported by the full compile.
+    {
+        StringSink discard;
+        OutputRedirect redirect(&discard);
+
+        // The tokens are only looked at, so their strings can go
+        // with them rather than into the cached statements' pools.
+        ConstantPool constants;
+        Source source(text, sourceFileName);
+        source.setConstantPool(&constants);
+        Scanner scanner(&source);
+
+        // PROGRAM name ; BEGIN
+        static const TokenType header[] =
+        {
+            TokenType::PROGRAM, TokenType::IDENTIFIER,
+            TokenType::SEMICOLON, TokenType::BEGIN
+        };
+
+        for (TokenType expected : header)
+        {
+            Token *token = scanner.nextToken();
+            bool ok = token->type == expected;
+
+            if (expected == TokenType::IDENTIFIER) programName = token->text;
+            if (expected == TokenType::BEGIN) beginLine = token->lineNumber;
+            delete token;
+
+            if (!ok) return nullptr;
+        }
+
+        // The line of the current character, which the source has
+        // already counted if the character ends a line.
+        auto currentLine = [&source]()
+        {
+            return source.lineNumber()
+                        - (source.currentChar() == Source::EOL ? 1 : 0);
+        };
+
+        int depth = 1;  // unclosed BEGINs and REPEATs
+        size_t start = source.position();
+        int firstLine = currentLine();
+
+        while (depth > 0)
+        {
+            Token *token = scanner.nextToken();
+            TokenType type = token->type;
+            size_t length = token->text.size();
+            delete token;
+
+            switch (type)
+            {
+                case TokenType::BEGIN :
+                case TokenType::REPEAT : depth++; break;
+                case TokenType::UNTIL  : depth--; break;
+
+                case TokenType::END :
+                {
+                    if (--depth == 0)
+                    {
+                        size_t end = source.position() - length;
+                        extents.push_back(Extent{start, end, firstLine});
+                    }
+                    break;
+                }
+
+                case TokenType::SEMICOLON :
+                {
+                    if (depth == 1)
+                    {
+                        size_t end = source.position() - length;
+                        extents.push_back(Extent{start, end, firstLine});
+                        start = source.position();
+                        firstLine = currentLine();
+                    }
+                    break;
+                }
+
+                case TokenType::END_OF_FILE :
+                case TokenType::ERROR : return nullptr;
+
+                default : break;
+            }
+        }
+
+        // The parser complains about a semicolon after the final END.
+        Token *token = scanner.nextToken();
+        bool ok = token->type != TokenType::SEMICOLON;
+        delete token;
+
+        if (!ok) return nullptr;
+    }
+
+    // Compile each statement, or reuse its cached trees.
+    Symtab declared;  // the variables assigned so far, in any slots
+    declared.enter(programName);
+
+    Node *compoundNode = new Node(NodeType::COMPOUND);
+    compoundNode->lineNumber = beginLine;
+
+    *totalCount = extents.size();
+
+    for (const Extent &extent : extents)
+    {
+        string statementText = text.substr(extent.start,
+                                           extent.end - extent.start);
+        Copies *copies = &cache[hash64(statementText)];
+
+        Statement *statement = findStatement(copies, statementText,
+                                             extent.firstLine, &declared);
+        if (statement == nullptr)
+        {
+            statement = compileStatement(statementText, extent.firstLine,
+                                         &declared);
+            if (statement == nullptr)
+            {
+                compoundNode->children.clear();
+                delete compoundNode;
+                return nullptr;
+            }
+
+            // Add it to the copies that are in use.
+            vector<Statement *> &statements = copies->statements;
+            statements.push_back(statement);
+            swap(statements[copies->usedCount++], statements.back());
+            (*parsedCount)++;
+        }
+
+        for (Node *node : statement->nodes) compoundNode->adopt(node);
+    }
+
+    Node *programNode = new Node(NodeType::PROGRAM);
+    programNode->text = programName;
+    programNode->adopt(compoundNode);
+
+    return programNode;
+}
+
+/**
+ * Find a cached statement with the given text that can be reused
+ * after the statements compiled so far.
+ * @param copies the cached statements with the text's hash.
+ * @param text the statement's text.
+ * @param firstLine the line its text now starts on.
+ * @param declared the variables assigned so far, to add its own to.
+ * @return the statement, or null if there isn't a reusable one.
+ */
+Watcher::Statement *Watcher::findStatement(Copies *copies, const string &text,
+                                           int firstLine, Symtab *declared)
+{
+    vector<Statement *> &statements = copies->statements;
+
+    for (size_t i = copies->usedCount; i < statements.size(); i++)
+    {
+        Statement *statement = statements[i];
+        if (statement->text != text) continue;
+
+        // Parsing it now would report an undeclared identifier.
+        bool ok = true;
+        for (const string &name : statement->reads)
+        {
+            if (declared->lookup(name) == nullptr) ok = false;
+        }
+        if (!ok) continue;
+
+        for (const string &name : statement->assigns)
+        {
+            if (declared->lookup(name) == nullptr) declared->enter(name);
+        }
+
+        // Lines were inserted or deleted above the statement.
+        if (statement->firstLine != firstLine)
+        {
+            for (Node *node : statement->nodes)
+            {
+                shiftLines(node, firstLine - statement->firstLine);
+            }
+            statement->firstLine = firstLine;
+        }
+
+        swap(statements[copies->usedCount++], statements[i]);
+        return statement;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Parse a top-level statement.
+ * @param text the statement's text.
+ * @param firstLine the line its text starts on.
+ * @param declared the variables assigned so far, to add its own to.
+ * @return the compiled statement, or null if it has errors.
+ */
+Watcher::Statement *Watcher::compileStatement(const string &text,
+                                              int firstLine,
+                                              Symtab *declared)
+{
+    int declaredCount = declared->size();
+    Statement *statement = new Statement();
+    Node *compoundNode;
+    int errorCount;
+
+    // Any errors will be reported by the full compile.
+    {
+        StringSink discard;
+        OutputRedirect redirect(&discard);
+
+        Source source(text, sourceFileName, firstLine);
+        source.setConstantPool(&statement->constants);
+        Scanner scanner(&source);
+        Parser parser(&scanner, declared);
+
+        compoundNode = parser.parseStatements();
+        errorCount = parser.getErrorCount();
+    }
+
+    if (errorCount > 0)
+    {
+        delete compoundNode;
+        delete statement;
+        return nullptr;
+    }
+
+    statement->text = text;
+    statement->firstLine = firstLine;
+    statement->nodes.swap(compoundNode->children);
+    delete compoundNode;
+
+    // Find the variables that it needed declared and that it declared,
+    // and move them from their slots in this version's symbol table
+    // to their permanent slots.
+    unordered_set<int> seen;
+    unordered_set<Node *> moved;  // hash-consed leaves already moved
+    vector<Node *> pending(statement->nodes);
+
+    while (!pending.empty())
+    {
+        Node *node = pending.back();
+        pending.pop_back();
+
+        for (Node *child : node->children) pending.push_back(child);
+        if (node->type != NodeType::VARIABLE) continue;
+        if ((node->sharers > 0) && !moved.insert(node).second) continue;
+
+        if (seen.insert(node->slot).second)
+        {
+            if (node->slot < declaredCount)
+            {
+                statement->reads.push_back(node->text);
+            }
+            else statement->assigns.push_back(node->text);
+        }
+
+        SymtabEntry *entry = slots.lookup(node->text);
+        if (entry == nullptr) entry = slots.enter(node->text);
+        node->slot = entry->getSlot();
+    }
+
+    return statement;
+}
+
+/**
+ * Compile and run the program the ordinary way,
+ * for its exact error messages.
+ */
+void Watcher::runFullCompile()
+{
+    try
+    {
+        Program program = Program::compileFile(sourceFileName);
+        Error error = program.getError();
+
+        if (!error.failed())
+        {
+            Context context = program.newContext();
+            error = program.run(context, output());
+        }
+
+        output().write(error.getMessage());
+    }
+    catch (const exception &ex)
+    {
+        output().print("*** ERROR: %s\n", ex.what());
+    }
+}
+
+/**
+ * Start over with none of the cached statements in use.
+ * @param evict true to first drop the ones the last version didn't use.
+ */
+void Watcher::endVersion(bool evict)
+{
+    for (auto it = cache.begin(); it != cache.end(); )
+    {
+        Copies &copies = it->second;
+
+        if (evict)
+        {
+            for (size_t i = copies.usedCount; i < copies.statements.size(); i++)
+            {
+                for (Node *node : copies.statements[i]->nodes) delete node;
+                delete copies.statements[i];
+            }
+
+            copies.statements.resize(copies.usedCount);
+        }
+
+        copies.usedCount = 0;
+
+        if (copies.statements.empty()) it = cache.erase(it);
+        else                           ++it;
+    }
+}
+
+/**
+ * Move a subtree's line numbers.
+ * @param node the root of the subtree.
+ * @param delta how many lines to move them by.
+ */
+void Watcher::shiftLines(Node *node, int delta)
+{
+    if (node->lineNumber > 0) node->lineNumber += delta;
+    for (Node *child : node->children) shiftLines(child, delta);
+}
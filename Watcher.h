@@ -0,0 +1,104 @@
+/**
+ * Watch mode for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef WATCHER_H_
+#define WATCHER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "Object.h"
+#include "intermediate/Symtab.h"
+#include "intermediate/Node.h"
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Runs a program, then runs it again every time its source file is
+ * saved, with the process and its compiled statements kept warm.
+ *
+ * Each top-level statement of the program's main BEGIN ... END block
+ * is compiled separately and cached by a hash of its text. After an
+ * edit, the file is scanned again to find the statements' extents,
+ * but only statements whose text changed are parsed again. A cached
+ * statement is reused only if every variable it reads is still
+ * assigned by some earlier statement, so the undeclared identifier
+ * errors are the same as for a full parse.
+ *
+ * Variables keep the frame slots they were first given for the life
+ * of the watch, so cached trees never need renumbering. If anything
+ * fails to compile, the whole file is compiled normally instead so
+ * that the error messages are exactly those of -execute.
+ */
+class Watcher
+{
+public:
+    /**
+     * Constructor.
+     * @param sourceFileName the source file to watch.
+     */
+    Watcher(const string &sourceFileName) : sourceFileName(sourceFileName) {}
+
+    /**
+     * Destructor.
+     */
+    ~Watcher();
+
+    /**
+     * Run the program and then rerun it after every change
+     * until the process is killed.
+     * @return -1 if the file can't be watched.
+     */
+    int watch();
+
+private:
+    /**
+     * A compiled top-level statement.
+     */
+    struct Statement
+    {
+        string text;              // its source text
+        vector<Node *> nodes;     // its trees (an empty statement has none)
+        int firstLine;            // the line its text started on
+        vector<string> reads;     // variables it needs assigned beforehand
+        vector<string> assigns;   // variables it assigns first
+        ConstantPool constants;   // the string literals of its trees
+    };
+
+    /**
+     * The cached statements with the same hash, which are usually
+     * copies of one statement. Those that the current version uses
+     * come first so that finding an unused copy is quick.
+     */
+    struct Copies
+    {
+        vector<Statement *> statements;
+        size_t usedCount = 0;
+    };
+
+    string sourceFileName;
+    Symtab slots;  // every variable ever seen, for its permanent slot
+
+    // Compiled statements by the hash of their text.
+    unordered_map<uint64_t, Copies> cache;
+
+    void rerun();
+    Node *compile(const string &text, int *parsedCount, int *totalCount);
+    Statement *compileStatement(const string &text, int firstLine,
+                                Symtab *declared);
+    Statement *findStatement(Copies *copies, const string &text,
+                             int firstLine, Symtab *declared);
+    void runFullCompile();
+    void endVersion(bool evict);
+
+    static void shiftLines(Node *node, int delta);
+};
+
+#endif /* WATCHER_H_ */
@@ -0,0 +1,75 @@
+/**
+ * Work-stealing thread pool for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <thread>
+
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+    : workers(threadCount > 0 ? threadCount : 1) {}
+
+void WorkStealingPool::run(size_t taskCount,
+                           const function<void(size_t)> &task)
+{
+    size_t workerCount = workers.size();
+
+    // Deal the tasks out round-robin. Each worker pops from the back
+    // of its own queue, so push each worker's share in reverse to
+    // have the earliest tasks start first.
+    for (size_t i = taskCount; i-- > 0; )
+    {
+        workers[i%workerCount].tasks.push_back(i);
+    }
+
+    vector<thread> threads;
+    for (size_t self = 0; self < workerCount; self++)
+    {
+        threads.emplace_back([this, self, &task]()
+        {
+            size_t taskIndex;
+            while (take(self, taskIndex)) task(taskIndex);
+        });
+    }
+
+    for (thread &t : threads) t.join();
+}
+
+bool WorkStealingPool::take(size_t self, size_t &taskIndex)
+{
+    // First try the back of this worker's own queue.
+    {
+        Worker &worker = workers[self];
+        lock_guard<mutex> guard(worker.lock);
+
+        if (!worker.tasks.empty())
+        {
+            taskIndex = worker.tasks.back();
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal from the front of the other workers' queues.
+    // No task creates new tasks, so once every queue is empty
+    // there's nothing left to do.
+    for (size_t i = 1; i < workers.size(); i++)
+    {
+        Worker &victim = workers[(self + i)%workers.size()];
+        lock_guard<mutex> guard(victim.lock);
+
+        if (!victim.tasks.empty())
+        {
+            taskIndex = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,54 @@
+/**
+ * Work-stealing thread pool for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+using namespace std;
+
+/**
+ * Runs a fixed set of independent tasks on a number of worker threads.
+ * Each worker has its own double-ended queue of task indices. A worker
+ * takes tasks from the back of its own queue and, when that's empty,
+ * steals from the front of another worker's queue, so long and short
+ * tasks balance out without a single shared queue to contend for.
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * Constructor.
+     * @param threadCount the number of worker threads, at least 1.
+     */
+    WorkStealingPool(int threadCount);
+
+    /**
+     * Run tasks 0 through taskCount - 1 and wait for all of them.
+     * Tasks start roughly in index order, but finish in any order.
+     * @param taskCount the number of tasks.
+     * @param task the function to call with each task index.
+     */
+    void run(size_t taskCount, const function<void(size_t)> &task);
+
+private:
+    struct Worker
+    {
+        mutex lock;
+        deque<size_t> tasks;
+    };
+
+    vector<Worker> workers;
+
+    bool take(size_t self, size_t &taskIndex);
+};
+
+#endif /* WORKSTEALINGPOOL_H_ */
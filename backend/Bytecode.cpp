@@ -0,0 +1,160 @@
+/**
+ * Bytecode program image format for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <string_view>
+#include <vector>
+#include <string.h>
+
+#include "../Hash.h"
+#include "Bytecode.h"
+
+namespace backend {
+
+using namespace std;
+
+constexpr char BytecodeImage::BYTECODE_MAGIC[8];
+
+BytecodeImage::BytecodeImage(string_view image)
+    : problem(nullptr), header(nullptr), code(nullptr), constants(nullptr),
+      strings(nullptr), slots(nullptr), text(nullptr)
+{
+    const BytecodeHeader *h = (const BytecodeHeader *) image.data();
+
+    if (   (image.size() < sizeof(BytecodeHeader))
+        || (memcmp(h->magic, BYTECODE_MAGIC, sizeof(h->magic)) != 0))
+    {
+        problem = "not a program image";
+        return;
+    }
+
+    if (h->byteOrder != BYTE_ORDER_MARK)
+    {
+        problem = "compiled for a different byte order";
+        return;
+    }
+
+    if (h->version != BYTECODE_VERSION)
+    {
+        problem = "compiled for a different interpreter version";
+        return;
+    }
+
+    if (hash64(image.substr(sizeof(BytecodeHeader))) != h->checksum)
+    {
+        problem = "checksum mismatch";
+        return;
+    }
+
+    // Check that everything the header describes is within the image.
+    if (   (h->codeCount == 0)
+        || (h->codeOffset != sizeof(BytecodeHeader))
+        || (h->codeOffset + (uint64_t) h->codeCount*sizeof(Instruction)
+                > h->constantsOffset)
+        || (h->constantsOffset + (uint64_t) h->constantCount*sizeof(double)
+                > h->stringsOffset)
+        || (h->stringsOffset + (uint64_t) h->stringCount*2*sizeof(uint32_t)
+                > h->slotsOffset)
+        || (h->slotsOffset + (uint64_t) h->slotCount*sizeof(uint32_t)
+                > h->textOffset)
+        || (h->textOffset + h->textSize != image.size()))
+    {
+        problem = "malformed image";
+        return;
+    }
+
+    header    = h;
+    code      = (const Instruction *) (image.data() + h->codeOffset);
+    constants = (const double *)      (image.data() + h->constantsOffset);
+    strings   = (const uint32_t *)    (image.data() + h->stringsOffset);
+    slots     = (const uint32_t *)    (image.data() + h->slotsOffset);
+    text      = image.data() + h->textOffset;
+
+    for (uint32_t i = 0; i < h->stringCount; i++)
+    {
+        if ((uint64_t) strings[2*i] + strings[2*i + 1] > h->textSize)
+        {
+            problem = "malformed image";
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < h->slotCount; i++)
+    {
+        if (slots[i] >= h->stringCount)
+        {
+            problem = "malformed image";
+            return;
+        }
+    }
+
+    if (!verifyCode()) problem = "invalid code";
+}
+
+/**
+ * Verify every instruction once so that the virtual machine doesn't
+ * have to check anything as it runs: each operand is in range, and
+ * the stack never underflows or grows beyond maxStack. The code
+ * generator leaves the stack empty at every jump and jump target,
+ * so the stack depth at each instruction follows from one pass.
+ * @return true if the code is valid.
+ */
+bool BytecodeImage::verifyCode()
+{
+    uint32_t count = header->codeCount;
+    vector<bool> isTarget(count + 1, false);
+
+    for (uint32_t pc = 0; pc < count; pc++)
+    {
+        const Instruction &instruction = code[pc];
+        if ((uint32_t) instruction.opcode >= (uint32_t) OPCODE_COUNT)
+        {
+            return false;
+        }
+
+        uint32_t operand = (uint32_t) instruction.operand;
+        switch (OPCODE_INFO[(int) instruction.opcode].operand)
+        {
+            case Operand::CONSTANT :
+                if (operand >= header->constantCount) return false;
+                break;
+            case Operand::SLOT :
+                if (operand >= header->slotCount) return false;
+                break;
+            case Operand::STRING :
+                if (operand >= header->stringCount) return false;
+                break;
+            case Operand::TARGET :
+                if (operand >= count) return false;
+                isTarget[operand] = true;
+                break;
+
+            default : break;
+        }
+    }
+
+    if (code[count - 1].opcode != Opcode::HALT) return false;
+
+    int depth = 0;
+    for (uint32_t pc = 0; pc < count; pc++)
+    {
+        const OpcodeInfo &info = OPCODE_INFO[(int) code[pc].opcode];
+
+        if (isTarget[pc] && (depth != 0)) return false;
+
+        depth -= info.pops;
+        if (depth < 0) return false;
+        depth += info.pushes;
+        if (depth > (int) header->maxStack) return false;
+
+        if ((info.operand == Operand::TARGET) && (depth != 0)) return false;
+    }
+
+    return true;
+}
+
+}  // namespace backend
@@ -0,0 +1,182 @@
+/**
+ * Bytecode program image format for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include <string>
+#include <string_view>
+#include <stdint.h>
+
+namespace backend {
+
+using namespace std;
+
+/**
+ * The instructions of the stack machine. Values on the stack are
+ * doubles; a boolean is 1.0 or 0.0.
+ */
+enum class Opcode : uint32_t
+{
+    PUSH,          // push constant [operand]
+    LOAD,          // push the variable in slot [operand]
+    STORE,         // pop into the variable in slot [operand]
+    ADD, SUBTRACT, MULTIPLY,
+    DIVIDE,        // string [operand] is the operator's text for errors
+    EQ, LT, LE, GT, GE, NE,
+    NOT,
+    JUMP,          // go to instruction [operand]
+    JUMP_IF_TRUE,  // pop, and go to instruction [operand] if true
+    LINE,          // a statement at source line [operand] starts
+    WRITE_NUMBER,  // pop the value, decimal places, and field width
+    WRITE_STRING,  // pop the decimal places and field width of string [operand]
+    NEWLINE,
+    HALT
+};
+
+constexpr int OPCODE_COUNT = (int) Opcode::HALT + 1;
+
+/**
+ * What an instruction's operand refers to.
+ */
+enum class Operand : uint8_t { NONE, CONSTANT, SLOT, STRING, TARGET, LINE };
+
+/**
+ * How each opcode is printed, what its operand is,
+ * and how many stack entries it pops and pushes.
+ */
+struct OpcodeInfo
+{
+    const char *name;
+    Operand operand;
+    int8_t pops;
+    int8_t pushes;
+};
+
+constexpr OpcodeInfo OPCODE_INFO[] =
+{
+    { "PUSH",         Operand::CONSTANT, 0, 1 },
+    { "LOAD",         Operand::SLOT,     0, 1 },
+    { "STORE",        Operand::SLOT,     1, 0 },
+    { "ADD",          Operand::NONE,     2, 1 },
+    { "SUBTRACT",     Operand::NONE,     2, 1 },
+    { "MULTIPLY",     Operand::NONE,     2, 1 },
+    { "DIVIDE",       Operand::STRING,   2, 1 },
+    { "EQ",           Operand::NONE,     2, 1 },
+    { "LT",           Operand::NONE,     2, 1 },
+    { "LE",           Operand::NONE,     2, 1 },
+    { "GT",           Operand::NONE,     2, 1 },
+    { "GE",           Operand::NONE,     2, 1 },
+    { "NE",           Operand::NONE,     2, 1 },
+    { "NOT",          Operand::NONE,     1, 1 },
+    { "JUMP",         Operand::TARGET,   0, 0 },
+    { "JUMP_IF_TRUE", Operand::TARGET,   1, 0 },
+    { "LINE",         Operand::LINE,     0, 0 },
+    { "WRITE_NUMBER", Operand::NONE,     3, 0 },
+    { "WRITE_STRING", Operand::STRING,   2, 0 },
+    { "NEWLINE",      Operand::NONE,     0, 0 },
+    { "HALT",         Operand::NONE,     0, 0 },
+};
+
+static_assert(sizeof(OPCODE_INFO)/sizeof(OpcodeInfo) == OPCODE_COUNT,
+              "every opcode needs an OPCODE_INFO entry");
+
+/**
+ * One fixed-size instruction.
+ */
+struct Instruction
+{
+    Opcode  opcode;
+    int32_t operand;
+};
+
+/**
+ * The header of a bytecode program image. The sections follow it
+ * in this order, each at the offset the header gives:
+ *   code       codeCount instructions
+ *   constants  constantCount doubles
+ *   strings    stringCount {offset, length} pairs into the text
+ *   slots      slotCount string indexes: the variables' names
+ *   text       textSize bytes
+ */
+struct BytecodeHeader
+{
+    char     magic[8];       // BYTECODE_MAGIC
+    uint32_t version;        // BYTECODE_VERSION
+    uint32_t byteOrder;      // BYTE_ORDER_MARK as written by the compiler
+    uint64_t checksum;       // hash of everything after the header
+    uint32_t codeCount;
+    uint32_t constantCount;
+    uint32_t stringCount;
+    uint32_t slotCount;
+    uint32_t maxStack;       // the deepest the operand stack gets
+    uint32_t textSize;
+    uint64_t codeOffset;     // offsets from the start of the image
+    uint64_t constantsOffset;
+    uint64_t stringsOffset;
+    uint64_t slotsOffset;
+    uint64_t textOffset;
+};
+
+/**
+ * A compiled program image: the instructions, the constant pool,
+ * the variables' names by slot, and the string constants, in one
+ * block of memory that can be written to a file and later mapped
+ * and executed in place. Source line numbers are carried by the
+ * LINE instructions at the start of each statement.
+ */
+class BytecodeImage
+{
+public:
+    static constexpr char BYTECODE_MAGIC[8] = { 'S', 'I', 'M', 'P', 'L', 'E',
+                                                'B', 'C' };
+    static const uint32_t BYTECODE_VERSION = 1;
+    static const uint32_t BYTE_ORDER_MARK  = 0x01020304;
+
+    /**
+     * Constructor. View an image, which must stay in memory,
+     * and verify it.
+     * @param image the image.
+     */
+    BytecodeImage(string_view image);
+
+    /**
+     * @return null if the image is valid, else why it isn't.
+     */
+    const char *getProblem() const { return problem; }
+
+    const Instruction *getCode() const { return code; }
+    const double *getConstants() const { return constants; }
+    int getSlotCount() const { return header->slotCount; }
+    int getMaxStack() const { return header->maxStack; }
+
+    /**
+     * @param index a string index.
+     * @return the string.
+     */
+    string_view getString(int index) const
+    {
+        return string_view(text + strings[2*index], strings[2*index + 1]);
+    }
+
+    string_view slotName(int slot) const { return getString(slots[slot]); }
+
+private:
+    const char *problem;
+    const BytecodeHeader *header;
+    const Instruction *code;
+    const double *constants;
+    const uint32_t *strings;
+    const uint32_t *slots;
+    const char *text;
+
+    bool verifyCode();
+};
+
+}  // namespace backend
+
+#endif /* BYTECODE_H_ */
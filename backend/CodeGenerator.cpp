@@ -0,0 +1,268 @@
+/**
+ * Bytecode generator for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <string_view>
+#include <vector>
+#include <string.h>
+
+#include "../Hash.h"
+#include "../intermediate/Node.h"
+#include "Bytecode.h"
+#include "CodeGenerator.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+string CodeGenerator::generate(Node *programNode,
+                               const vector<string> &slotNames)
+{
+    CodeGenerator generator;
+    generator.visit(programNode);
+    generator.emit(Opcode::HALT);
+
+    vector<uint32_t> slots;
+    for (const string &name : slotNames)
+    {
+        slots.push_back(generator.stringIndex(name));
+    }
+
+    const vector<Instruction> &code = generator.code;
+    const vector<double> &constants = generator.constants;
+    const vector<uint32_t> &strings = generator.strings;
+    const string &text = generator.text;
+
+    BytecodeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BytecodeImage::BYTECODE_MAGIC, sizeof(header.magic));
+    header.version         = BytecodeImage::BYTECODE_VERSION;
+    header.byteOrder       = BytecodeImage::BYTE_ORDER_MARK;
+    header.codeCount       = code.size();
+    header.constantCount   = constants.size();
+    header.stringCount     = strings.size()/2;
+    header.slotCount       = slots.size();
+    header.maxStack        = generator.maxStack;
+    header.textSize        = text.size();
+    header.codeOffset      = sizeof(BytecodeHeader);
+    header.constantsOffset =   header.codeOffset
+                             + code.size()*sizeof(Instruction);
+    header.stringsOffset   =   header.constantsOffset
+                             + constants.size()*sizeof(double);
+    header.slotsOffset     =   header.stringsOffset
+                             + strings.size()*sizeof(uint32_t);
+    header.textOffset      =   header.slotsOffset
+                             + slots.size()*sizeof(uint32_t);
+
+    string image;
+    image.reserve(header.textOffset + text.size());
+    image.append((const char *) &header, sizeof(header));
+    image.append((const char *) code.data(), code.size()*sizeof(Instruction));
+    image.append((const char *) constants.data(),
+                 constants.size()*sizeof(double));
+    image.append((const char *) strings.data(),
+                 strings.size()*sizeof(uint32_t));
+    image.append((const char *) slots.data(), slots.size()*sizeof(uint32_t));
+    image.append(text);
+
+    // Checksum everything after the header.
+    header.checksum = hash64(string_view(image).substr(sizeof(header)));
+    memcpy(&image[0], &header, sizeof(header));
+
+    return image;
+}
+
+void CodeGenerator::visitProgram(Node *programNode)
+{
+    visit(programNode->children[0]);
+}
+
+void CodeGenerator::visitCompound(Node *compoundNode)
+{
+    emit(Opcode::LINE, compoundNode->lineNumber);
+    for (Node *statementNode : compoundNode->children) visit(statementNode);
+}
+
+void CodeGenerator::visitAssign(Node *assignNode)
+{
+    emit(Opcode::LINE, assignNode->lineNumber);
+    generateDouble(assignNode->children[1]);
+    emit(Opcode::STORE, assignNode->children[0]->slot);
+}
+
+void CodeGenerator::visitLoop(Node *loopNode)
+{
+    emit(Opcode::LINE, loopNode->lineNumber);
+
+    // Each test jumps out of the loop when it's true,
+    // so the exits are patched once the loop's end is known.
+    int top = code.size();
+    vector<int> exits;
+
+    for (Node *node : loopNode->children)
+    {
+        if (node->type == TEST)
+        {
+            generateBool(node->children[0]);
+            exits.push_back(emit(Opcode::JUMP_IF_TRUE));
+        }
+        else visit(node);  // statement
+    }
+
+    emit(Opcode::JUMP, top);
+    for (int exitIndex : exits) code[exitIndex].operand = code.size();
+}
+
+void CodeGenerator::visitWrite(Node *writeNode)
+{
+    emit(Opcode::LINE, writeNode->lineNumber);
+    generateWrite(writeNode->children);
+}
+
+void CodeGenerator::visitWriteln(Node *writelnNode)
+{
+    emit(Opcode::LINE, writelnNode->lineNumber);
+    if (writelnNode->children.size() > 0) generateWrite(writelnNode->children);
+    emit(Opcode::NEWLINE);
+}
+
+void CodeGenerator::generateWrite(const vector<Node *> &children)
+{
+    // The field width and count of decimal places, then the value.
+    if (children.size() > 1) generateLong(children[1]);
+    else                     emit(Opcode::PUSH, constantIndex(-1));
+
+    if (children.size() > 2) generateLong(children[2]);
+    else                     emit(Opcode::PUSH, constantIndex(0));
+
+    Node *valueNode = children[0];
+    if (valueNode->type == VARIABLE)
+    {
+        emit(Opcode::LOAD, valueNode->slot);
+        emit(Opcode::WRITE_NUMBER);
+    }
+    else emit(Opcode::WRITE_STRING, stringIndex(valueNode->value.S()));
+}
+
+void CodeGenerator::generateDouble(Node *expressionNode)
+{
+    Opcode opcode;
+
+    switch (expressionNode->type)
+    {
+        case VARIABLE :
+            emit(Opcode::LOAD, expressionNode->slot);
+            return;
+
+        case INTEGER_CONSTANT :
+        case REAL_CONSTANT :
+            emit(Opcode::PUSH, constantIndex(expressionNode->value.D()));
+            return;
+
+        case ADD      : opcode = Opcode::ADD;      break;
+        case SUBTRACT : opcode = Opcode::SUBTRACT; break;
+        case MULTIPLY : opcode = Opcode::MULTIPLY; break;
+        case DIVIDE   : opcode = Opcode::DIVIDE;   break;
+
+        default :  // a boolean or string has no numeric value
+            emit(Opcode::PUSH, constantIndex(0.0));
+            return;
+    }
+
+    generateDouble(expressionNode->children[0]);
+    generateDouble(expressionNode->children[1]);
+
+    if (opcode == Opcode::DIVIDE)
+    {
+        emit(opcode, stringIndex(expressionNode->text));
+    }
+    else emit(opcode);
+}
+
+void CodeGenerator::generateLong(Node *expressionNode)
+{
+    // The machine truncates when it uses a value as a long.
+    if (expressionNode->type == INTEGER_CONSTANT)
+    {
+        emit(Opcode::PUSH, constantIndex(expressionNode->value.L()));
+    }
+    else generateDouble(expressionNode);
+}
+
+void CodeGenerator::generateBool(Node *expressionNode)
+{
+    if (expressionNode->type == NOT)
+    {
+        generateBool(expressionNode->children[0]);
+        emit(Opcode::NOT);
+        return;
+    }
+
+    if (!relationals.contains(expressionNode->type))
+    {
+        // A number or string has no boolean value.
+        emit(Opcode::PUSH, constantIndex(0.0));
+        return;
+    }
+
+    generateDouble(expressionNode->children[0]);
+    generateDouble(expressionNode->children[1]);
+
+    switch (expressionNode->type)
+    {
+        case EQ : emit(Opcode::EQ); break;
+        case LT : emit(Opcode::LT); break;
+        case LE : emit(Opcode::LE); break;
+        case GT : emit(Opcode::GT); break;
+        case GE : emit(Opcode::GE); break;
+        case NE : emit(Opcode::NE); break;
+
+        default : break;
+    }
+}
+
+int CodeGenerator::emit(Opcode opcode, int operand)
+{
+    const OpcodeInfo &info = OPCODE_INFO[(int) opcode];
+    depth += info.pushes - info.pops;
+    if (depth > maxStack) maxStack = depth;
+
+    code.push_back({opcode, operand});
+    return code.size() - 1;
+}
+
+int CodeGenerator::constantIndex(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    auto it = constantIndexes.find(bits);
+    if (it != constantIndexes.end()) return it->second;
+
+    constants.push_back(value);
+    constantIndexes[bits] = constants.size() - 1;
+
+    return constants.size() - 1;
+}
+
+int CodeGenerator::stringIndex(string_view value)
+{
+    string key(value);
+
+    auto it = stringIndexes.find(key);
+    if (it != stringIndexes.end()) return it->second;
+
+    strings.push_back(text.size());
+    strings.push_back(value.size());
+    text.append(value);
+    stringIndexes[key] = strings.size()/2 - 1;
+
+    return strings.size()/2 - 1;
+}
+
+}  // namespace backend
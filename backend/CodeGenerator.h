@@ -0,0 +1,96 @@
+/**
+ * Bytecode generator for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CODEGENERATOR_H_
+#define CODEGENERATOR_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "../EnumSet.h"
+#include "../intermediate/Node.h"
+#include "../intermediate/TreeVisitor.h"
+#include "Bytecode.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Compiles a parse tree into a bytecode program image. The code
+ * evaluates everything in the order the Executor does, so a run of
+ * the image prints the same output and fails with the same
+ * runtime errors as executing the tree.
+ */
+class CodeGenerator : public TreeVisitor<CodeGenerator, void>
+{
+    friend class TreeVisitor<CodeGenerator, void>;
+
+public:
+    /**
+     * Generate the image of a program.
+     * @param programNode the root of the program's parse tree.
+     * @param slotNames the variables' names indexed by slot.
+     * @return the image.
+     */
+    static string generate(Node *programNode, const vector<string> &slotNames);
+
+private:
+    vector<Instruction> code;
+    vector<double> constants;
+    vector<uint32_t> strings;  // {offset, length} pairs into the text
+    string text;
+    unordered_map<uint64_t, int> constantIndexes;  // by the value's bits
+    unordered_map<string, int> stringIndexes;
+    int depth;     // the current operand stack depth
+    int maxStack;
+
+    CodeGenerator() : depth(0), maxStack(0) {}
+
+    // Relational operators.
+    static constexpr EnumSet<NodeType> relationals =
+    {
+        EQ, LT, LE, GT, GE, NE
+    };
+
+    void visitProgram(Node *programNode);
+    void visitCompound(Node *compoundNode);
+    void visitAssign(Node *assignNode);
+    void visitLoop(Node *loopNode);
+    void visitWrite(Node *writeNode);
+    void visitWriteln(Node *writelnNode);
+
+    /**
+     * Generate the code to evaluate an expression subtree,
+     * as the Executor's evalDouble(), evalLong(), or evalBool().
+     * @param expressionNode the root of the subtree.
+     */
+    void generateDouble(Node *expressionNode);
+    void generateLong(Node *expressionNode);
+    void generateBool(Node *expressionNode);
+
+    void generateWrite(const vector<Node *> &children);
+
+    /**
+     * Append an instruction.
+     * @param opcode the opcode.
+     * @param operand the operand, if any.
+     * @return the instruction's index.
+     */
+    int emit(Opcode opcode, int operand = 0);
+
+    int constantIndex(double value);
+    int stringIndex(string_view value);
+};
+
+}  // namespace backend
+
+#endif /* CODEGENERATOR_H_ */
@@ -0,0 +1,36 @@
+/**
+ * Execution context class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CONTEXT_H_
+#define CONTEXT_H_
+
+#include <vector>
+
+namespace backend {
+
+using namespace std;
+
+/**
+ * The per-run state of a program: one value per symbol table slot.
+ * The parse tree itself is never written to during execution,
+ * so any number of contexts can run the same tree at once.
+ */
+class Context
+{
+public:
+    vector<double> values;  // variable values indexed by frame slot
+
+    /**
+     * Constructor.
+     * @param slotCount the number of frame slots (Symtab::size()).
+     */
+    Context(int slotCount) : values(slotCount, 0.0) {}
+};
+
+}  // namespace backend
+
+#endif /* CONTEXT_H_ */
@@ -9,54 +9,64 @@
 #define EXECUTOR_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 
 #include "../Object.h"
 #include "../intermediate/Symtab.h"
 #include "../intermediate/Node.h"
+#include "../intermediate/TreeVisitor.h"
+#include "Context.h"
+#include "TreeEvaluator.h"
 
 namespace backend {
 
 using namespace std;
 using namespace intermediate;
 
-class Executor
+/**
+ * Gets at the fields and children of a parse tree of Node objects
+ * for a TreeEvaluator.
+ */
+struct NodeAccess
+{
+    typedef Node *NodeRef;
+
+    NodeType type(Node *node) const       { return node->type; }
+    int lineNumber(Node *node) const      { return node->lineNumber; }
+    int slot(Node *node) const            { return node->slot; }
+    size_t childCount(Node *node) const   { return node->children.size(); }
+    Node *child(Node *node, size_t i) const { return node->children[i]; }
+
+    double doubleValue(Node *node) const      { return node->value.D(); }
+    long longValue(Node *node) const          { return node->value.L(); }
+    string_view stringValue(Node *node) const { return node->value.S(); }
+    string_view text(Node *node) const        { return node->text; }
+};
+
+class Executor : public TreeVisitor<Executor, Object>
 {
+    friend class TreeVisitor<Executor, Object>;
+
 private:
-    int lineNumber;
+    TreeEvaluator<NodeAccess> evaluator;
 
 public:
     /**
-     * Initialize the static sets.
+     * Constructor. The program's output goes to the
+     * calling thread's current output sink.
+     * @param context the execution context to read and write variables in.
      */
-    static void initialize();
-
-    Executor() : lineNumber(0) {}
-
-    Object visit(Node *node);
+    Executor(Context *context) : evaluator(NodeAccess(), context) {}
 
 private:
-    static set<NodeType> singletons;   // singleton factors
-    static set<NodeType> relationals;  // relational operators
-
     Object visitProgram(Node *programNode);
     Object visitStatement(Node *statementNode);
-    Object visitCompound(Node *compoundNode);
-    Object visitAssign(Node *assignNode);
-    Object visitLoop(Node *loopNode);
     Object visitTest(Node *testNode);
-    Object visitWrite(Node *writeNode);
-    Object visitWriteln(Node *writelnNode);
     Object visitExpression(Node *expressionNode);
-    Object visitVariable(Node *variableNode);
     Object visitIntegerConstant(Node *integerConstantNode);
     Object visitRealConstant(Node *realConstantNode);
     Object visitStringConstant(Node *stringConstantNode);
-    Object visitNot(Node *notNode);
-
-    void printValue(vector<Node *> children);
-    void runtimeError(Node *node, string message);
 };
 
 }  // namespace backend
@@ -0,0 +1,111 @@
+/**
+ * Flat parse tree executor for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef FLATEXECUTOR_H_
+#define FLATEXECUTOR_H_
+
+#include <string_view>
+
+#include "../Object.h"
+#include "../intermediate/FlatTree.h"
+#include "Context.h"
+#include "TreeEvaluator.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Gets at the fields and children of a parse tree in the flat format
+ * for a TreeEvaluator.
+ */
+struct FlatNodeAccess
+{
+    typedef const FlatNode *NodeRef;
+
+    const FlatTree *tree;
+
+    NodeType type(const FlatNode *node) const
+    {
+        return (NodeType) node->type;
+    }
+
+    int lineNumber(const FlatNode *node) const { return node->lineNumber; }
+    int slot(const FlatNode *node) const       { return node->slot; }
+
+    size_t childCount(const FlatNode *node) const
+    {
+        return node->childCount;
+    }
+
+    const FlatNode *child(const FlatNode *node, size_t i) const
+    {
+        return tree->child(node, (uint32_t) i);
+    }
+
+    double doubleValue(const FlatNode *node) const
+    {
+        switch ((Object::Type) node->valueType)
+        {
+            case Object::Type::LONG   : return node->value.l;
+            case Object::Type::DOUBLE : return node->value.d;
+            default                   : return 0.0;
+        }
+    }
+
+    long longValue(const FlatNode *node) const
+    {
+        switch ((Object::Type) node->valueType)
+        {
+            case Object::Type::LONG   : return node->value.l;
+            case Object::Type::DOUBLE : return (long) node->value.d;
+            default                   : return 0;
+        }
+    }
+
+    string_view stringValue(const FlatNode *node) const
+    {
+        return node->valueType == (uint8_t) Object::Type::STRING
+                    ? tree->stringValue(node) : string_view();
+    }
+
+    string_view text(const FlatNode *node) const { return tree->text(node); }
+};
+
+/**
+ * Executes a parse tree in the flat format in place, e.g. straight
+ * from a memory-mapped file. It shares its evaluation with the
+ * Executor, so it behaves exactly as the Executor does on the tree
+ * the flat one was made from.
+ */
+class FlatExecutor
+{
+private:
+    const FlatTree *tree;
+    TreeEvaluator<FlatNodeAccess> evaluator;
+
+public:
+    /**
+     * Constructor. The program's output goes to the
+     * calling thread's current output sink.
+     * @param tree the flat tree to execute.
+     * @param context the execution context to read and write variables in.
+     */
+    FlatExecutor(const FlatTree *tree, Context *context)
+        : tree(tree), evaluator(FlatNodeAccess{tree}, context) {}
+
+    /**
+     * Execute the program.
+     * @throw RuntimeError if it fails.
+     */
+    void execute() { evaluator.executeStatement(tree->getRoot()); }
+};
+
+}  // namespace backend
+
+#endif /* FLATEXECUTOR_H_ */
@@ -0,0 +1,319 @@
+/**
+ * Parse tree evaluator template for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef TREEEVALUATOR_H_
+#define TREEEVALUATOR_H_
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+
+#include "../EnumSet.h"
+#include "../Output.h"
+#include "../intermediate/Node.h"
+#include "Context.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Thrown when a program fails at run time, e.g. a division by zero.
+ * The message is the complete RUNTIME ERROR line to report.
+ */
+class RuntimeError : public runtime_error
+{
+public:
+    RuntimeError(const string &message) : runtime_error(message) {}
+};
+
+/**
+ * The semantics of executing a parse tree, shared by the executors of
+ * the pointer and flat tree formats. An access policy class says how
+ * to get at the nodes of a format:
+ *
+ *   typedef ... NodeRef;                    // how a node is referred to
+ *   NodeType    type(NodeRef node) const;
+ *   int         lineNumber(NodeRef node) const;
+ *   int         slot(NodeRef node) const;
+ *   size_t      childCount(NodeRef node) const;
+ *   NodeRef     child(NodeRef node, size_t i) const;
+ *   double      doubleValue(NodeRef node) const;  // of a constant
+ *   long        longValue(NodeRef node) const;
+ *   string_view stringValue(NodeRef node) const;
+ *   string_view text(NodeRef node) const;
+ *
+ * Every call is bound statically, so the compiler is free to inline
+ * the policy's functions into the evaluation.
+ */
+template <class Access>
+class TreeEvaluator
+{
+public:
+    typedef typename Access::NodeRef NodeRef;
+
+    /**
+     * Constructor. The program's output goes to the
+     * calling thread's current output sink.
+     * @param access the policy to get at the nodes with.
+     * @param context the execution context to read and write variables in.
+     */
+    TreeEvaluator(const Access &access, Context *context)
+        : access(access), frame(context->values.data()), out(&output()),
+          lineNumber(0) {}
+
+    /**
+     * Execute a statement. An expression has no effect.
+     * @param node the statement's node.
+     * @throw RuntimeError if it fails.
+     */
+    void executeStatement(NodeRef node)
+    {
+        switch (access.type(node))
+        {
+            case PROGRAM :
+            {
+                executeStatement(access.child(node, 0));
+                break;
+            }
+
+            case COMPOUND :
+            {
+                lineNumber = access.lineNumber(node);
+
+                size_t count = access.childCount(node);
+                for (size_t i = 0; i < count; i++)
+                {
+                    executeStatement(access.child(node, i));
+                }
+                break;
+            }
+
+            case ASSIGN :
+            {
+                lineNumber = access.lineNumber(node);
+
+                NodeRef lhs = access.child(node, 0);
+                NodeRef rhs = access.child(node, 1);
+
+                // Store the value into the variable's frame slot.
+                frame[access.slot(lhs)] = evalDouble(rhs);
+                break;
+            }
+
+            case LOOP :
+            {
+                executeLoop(node);
+                break;
+            }
+
+            case WRITE :
+            {
+                lineNumber = access.lineNumber(node);
+                printValue(node);
+                break;
+            }
+
+            case WRITELN :
+            {
+                lineNumber = access.lineNumber(node);
+                if (access.childCount(node) > 0) printValue(node);
+                out->put('\n');
+                break;
+            }
+
+            default : break;
+        }
+    }
+
+    /**
+     * Evaluate an expression subtree whose type is known statically,
+     * without constructing an Object for each intermediate result.
+     * @param expressionNode the root of the subtree.
+     * @return the value.
+     */
+    double evalDouble(NodeRef expressionNode)
+    {
+        switch (access.type(expressionNode))
+        {
+            case VARIABLE : return frame[access.slot(expressionNode)];
+
+            case INTEGER_CONSTANT :
+            case REAL_CONSTANT    : return access.doubleValue(expressionNode);
+
+            case ADD :      return   evalDouble(access.child(expressionNode, 0))
+                                   + evalDouble(access.child(expressionNode, 1));
+            case SUBTRACT : return   evalDouble(access.child(expressionNode, 0))
+                                   - evalDouble(access.child(expressionNode, 1));
+            case MULTIPLY : return   evalDouble(access.child(expressionNode, 0))
+                                   * evalDouble(access.child(expressionNode, 1));
+
+            case DIVIDE :
+            {
+                double value1 = evalDouble(access.child(expressionNode, 0));
+                double value2 = evalDouble(access.child(expressionNode, 1));
+
+                if (value2 != 0.0) return value1/value2;
+
+                runtimeError(expressionNode, "Division by zero");
+                return 0.0;
+            }
+
+            default : return 0.0;  // a boolean or string has no numeric value
+        }
+    }
+
+    long evalLong(NodeRef expressionNode)
+    {
+        if (access.type(expressionNode) == INTEGER_CONSTANT)
+        {
+            return access.longValue(expressionNode);
+        }
+
+        return (long) evalDouble(expressionNode);
+    }
+
+    bool evalBool(NodeRef expressionNode)
+    {
+        NodeType type = access.type(expressionNode);
+
+        // Not
+        if (type == NOT)
+        {
+            return !evalBool(access.child(expressionNode, 0));
+        }
+
+        // Relational expressions.
+        if (!relationals.contains(type))
+        {
+            return false;  // a number or string has no boolean value
+        }
+
+        double value1 = evalDouble(access.child(expressionNode, 0));
+        double value2 = evalDouble(access.child(expressionNode, 1));
+
+        switch (type)
+        {
+            case EQ : return value1 == value2;
+            case LT : return value1 <  value2;
+            case LE : return value1 <= value2;
+            case GT : return value1 >  value2;
+            case GE : return value1 >= value2;
+            case NE : return value1 != value2;
+
+            default : return false;
+        }
+    }
+
+    /**
+     * @param type a node type.
+     * @return true if an expression of the type has a boolean value.
+     */
+    static bool isBoolean(NodeType type)
+    {
+        return relationals.contains(type) || (type == NOT);
+    }
+
+private:
+    // Relational operators.
+    static constexpr EnumSet<NodeType> relationals =
+    {
+        EQ, LT, LE, GT, GE, NE
+    };
+
+    Access access;
+    double *frame;     // the variable values of this run, indexed by slot
+    OutputSink *out;   // where the program's output goes
+    int lineNumber;
+
+    void executeLoop(NodeRef loopNode)
+    {
+        lineNumber = access.lineNumber(loopNode);
+
+        size_t count = access.childCount(loopNode);
+        bool b = false;
+        do
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                NodeRef node = access.child(loopNode, i);
+
+                // Evaluate the test condition. Stop looping if true.
+                if (access.type(node) == TEST)
+                {
+                    b = evalBool(access.child(node, 0));
+                    if (b) break;
+                }
+                else executeStatement(node);
+            }
+        } while (!b);
+    }
+
+    void printValue(NodeRef node)
+    {
+        size_t childCount = access.childCount(node);
+        long fieldWidth    = -1;
+        long decimalPlaces = 0;
+
+        // Use any specified field width and count of decimal places.
+        if (childCount > 1)
+        {
+            fieldWidth = evalLong(access.child(node, 1));
+
+            if (childCount > 2)
+            {
+                decimalPlaces = evalLong(access.child(node, 2));
+            }
+        }
+
+        // Print the value. Pass the width and precision as print
+        // arguments rather than building a format string at run time.
+        NodeRef valueNode = access.child(node, 0);
+        if (access.type(valueNode) == VARIABLE)
+        {
+            double value = evalDouble(valueNode);
+
+            if (fieldWidth >= 0) out->print("%*.*f", (int) fieldWidth,
+                                            (int) decimalPlaces, value);
+            else                 out->print("%.*f", (int) decimalPlaces, value);
+        }
+        else  // STRING_CONSTANT
+        {
+            // Write the constant straight from where it's kept,
+            // right-justified in the field.
+            string_view value = access.stringValue(valueNode);
+
+            static const char SPACES[] = "                                ";
+            for (long pad = fieldWidth - (long) value.size(); pad > 0; )
+            {
+                long count = min(pad, (long) sizeof(SPACES) - 1);
+                out->write(SPACES, count);
+                pad -= count;
+            }
+            out->write(value);
+        }
+    }
+
+    /**
+     * Stop execution with a runtime error.
+     * @param node the node where the error occurred.
+     * @param message the error message.
+     * @throw RuntimeError always.
+     */
+    void runtimeError(NodeRef node, string message)
+    {
+        throw RuntimeError("RUNTIME ERROR at line " + to_string(lineNumber)
+                           + ": " + message + ": "
+                           + string(access.text(node)));
+    }
+};
+
+}  // namespace backend
+
+#endif /* TREEEVALUATOR_H_ */
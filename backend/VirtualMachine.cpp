@@ -0,0 +1,124 @@
+/**
+ * Bytecode virtual machine for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <string_view>
+
+#include "Bytecode.h"
+#include "VirtualMachine.h"
+
+namespace backend {
+
+using namespace std;
+
+void VirtualMachine::execute()
+{
+    const Instruction *code = image->getCode();
+    const double *constants = image->getConstants();
+
+    // The image was verified, so no operand or stack depth is checked here.
+    const Instruction *pc = code;
+    double *top = stack.data() - 1;  // the top of the operand stack
+    int lineNumber = 0;
+
+    for (;;)
+    {
+        const Instruction &instruction = *pc++;
+
+        switch (instruction.opcode)
+        {
+            case Opcode::PUSH : *++top = constants[instruction.operand]; break;
+            case Opcode::LOAD : *++top = frame[instruction.operand];     break;
+            case Opcode::STORE: frame[instruction.operand] = *top--;     break;
+
+            case Opcode::ADD      : top[-1] += top[0]; top--; break;
+            case Opcode::SUBTRACT : top[-1] -= top[0]; top--; break;
+            case Opcode::MULTIPLY : top[-1] *= top[0]; top--; break;
+
+            case Opcode::DIVIDE :
+            {
+                if (top[0] == 0.0)
+                {
+                    runtimeError(lineNumber, "Division by zero",
+                                 image->getString(instruction.operand));
+                }
+
+                top[-1] /= top[0];
+                top--;
+                break;
+            }
+
+            case Opcode::EQ : top[-1] = top[-1] == top[0]; top--; break;
+            case Opcode::LT : top[-1] = top[-1] <  top[0]; top--; break;
+            case Opcode::LE : top[-1] = top[-1] <= top[0]; top--; break;
+            case Opcode::GT : top[-1] = top[-1] >  top[0]; top--; break;
+            case Opcode::GE : top[-1] = top[-1] >= top[0]; top--; break;
+            case Opcode::NE : top[-1] = top[-1] != top[0]; top--; break;
+
+            case Opcode::NOT : top[0] = top[0] == 0.0; break;
+
+            case Opcode::JUMP : pc = code + instruction.operand; break;
+
+            case Opcode::JUMP_IF_TRUE :
+            {
+                if (*top-- != 0.0) pc = code + instruction.operand;
+                break;
+            }
+
+            case Opcode::LINE : lineNumber = instruction.operand; break;
+
+            case Opcode::WRITE_NUMBER :
+            {
+                writeNumber((long) top[-2], (long) top[-1], top[0]);
+                top -= 3;
+                break;
+            }
+
+            case Opcode::WRITE_STRING :
+            {
+                writeString((long) top[-1],
+                            image->getString(instruction.operand));
+                top -= 2;
+                break;
+            }
+
+            case Opcode::NEWLINE : out->put('\n'); break;
+
+            case Opcode::HALT : return;
+        }
+    }
+}
+
+void VirtualMachine::writeNumber(long fieldWidth, long decimalPlaces,
+                                 double value)
+{
+    if (fieldWidth >= 0) out->print("%*.*f", (int) fieldWidth,
+                                    (int) decimalPlaces, value);
+    else                 out->print("%.*f", (int) decimalPlaces, value);
+}
+
+void VirtualMachine::writeString(long fieldWidth, string_view value)
+{
+    // Right-justify the string in the field.
+    static const char SPACES[] = "                                ";
+    for (long pad = fieldWidth - (long) value.size(); pad > 0; )
+    {
+        long count = min(pad, (long) sizeof(SPACES) - 1);
+        out->write(SPACES, count);
+        pad -= count;
+    }
+    out->write(value);
+}
+
+void VirtualMachine::runtimeError(int lineNumber, string message,
+                                  string_view text)
+{
+    throw RuntimeError("RUNTIME ERROR at line " + to_string(lineNumber)
+                       + ": " + message + ": " + string(text));
+}
+
+}  // namespace backend
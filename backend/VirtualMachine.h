@@ -0,0 +1,69 @@
+/**
+ * Bytecode virtual machine for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef VIRTUALMACHINE_H_
+#define VIRTUALMACHINE_H_
+
+#include <string>
+#include <vector>
+
+#include "../Output.h"
+#include "Bytecode.h"
+#include "Context.h"
+#include "Executor.h"
+
+namespace backend {
+
+using namespace std;
+
+/**
+ * Executes a verified bytecode program image in place, e.g. straight
+ * from a memory-mapped file. It behaves exactly as the Executor does
+ * on the tree the image was compiled from.
+ */
+class VirtualMachine
+{
+private:
+    const BytecodeImage *image;
+    double *frame;          // the variable values of this run, indexed by slot
+    vector<double> stack;   // the operand stack
+    OutputSink *out;        // where the program's output goes
+
+public:
+    /**
+     * Constructor. The program's output goes to the
+     * calling thread's current output sink.
+     * @param image the verified image to execute.
+     * @param context the execution context to read and write variables in.
+     */
+    VirtualMachine(const BytecodeImage *image, Context *context)
+        : image(image), frame(context->values.data()),
+          stack(image->getMaxStack() + 1), out(&output()) {}
+
+    /**
+     * Execute the program.
+     * @throw RuntimeError if it fails.
+     */
+    void execute();
+
+private:
+    void writeNumber(long fieldWidth, long decimalPlaces, double value);
+    void writeString(long fieldWidth, string_view value);
+
+    /**
+     * Stop execution with a runtime error.
+     * @param lineNumber the line of the statement where it occurred.
+     * @param message the error message.
+     * @param text the text of the operator where it occurred.
+     * @throw RuntimeError always.
+     */
+    void runtimeError(int lineNumber, string message, string_view text);
+};
+
+}  // namespace backend
+
+#endif /* VIRTUALMACHINE_H_ */
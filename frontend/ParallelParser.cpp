@@ -0,0 +1,353 @@
+/**
+ * Parallel parser for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "../Output.h"
+#include "../WorkStealingPool.h"
+#include "Source.h"
+#include "Scanner.h"
+#include "Token.h"
+#include "Parser.h"
+#include "ParallelParser.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate;
+
+Node *ParallelParser::parseProgram(string_view text, const string &name,
+                                   Symtab *symtab, ConstantPool *constantPool)
+{
+    if ((threadCount < 2) || (text.size() < MIN_PARALLEL_SIZE)) return nullptr;
+
+    constants = constantPool;
+
+    Layout layout;
+    string programName;
+    int beginLine;
+
+    if (   !prescan(text, &layout)
+        || !checkHeading(text.substr(0, layout.bodyStart), name,
+                         &programName, &beginLine)
+        || !checkEnding(text.substr(layout.bodyEnd), name, layout.endLine))
+    {
+        return nullptr;
+    }
+
+    // Cut the body into ranges of whole statements.
+    size_t rangeCount = threadCount*RANGES_PER_THREAD;
+    size_t target = (layout.bodyEnd - layout.bodyStart)/rangeCount;
+    vector<Range> ranges(1);
+    ranges.reserve(layout.boundaries.size() + 1);
+    ranges[0].start = layout.bodyStart;
+    ranges[0].firstLine = beginLine;
+
+    for (size_t i = 0; i < layout.boundaries.size(); i++)
+    {
+        size_t boundary = layout.boundaries[i];
+        if (boundary - ranges.back().start >= target)
+        {
+            ranges.back().end = boundary;
+            ranges.emplace_back();
+            ranges.back().start = boundary;
+            ranges.back().firstLine = layout.boundaryLines[i];
+        }
+    }
+
+    ranges.back().end = layout.bodyEnd;
+
+    WorkStealingPool pool(threadCount);
+    pool.run(ranges.size(),
+             [&](size_t i) { parseRange(text, name, &ranges[i]); });
+
+    // The ranges were parsed for this thread, so count
+    // their memory use as its own.
+    for (const Range &range : ranges)
+    {
+        MemoryCounters::forThread().add(range.counts);
+    }
+
+    bool failed = any_of(ranges.begin(), ranges.end(),
+                         [](const Range &range) { return range.failed; });
+
+    // Merge the symbol tables in source order. A name that a range
+    // used before assigning it must have been assigned by an earlier
+    // range, or else the program has an undeclared identifier.
+    Symtab merged;
+    merged.enter(programName);
+    vector<vector<int>> remaps(ranges.size());
+
+    for (size_t r = 0; !failed && (r < ranges.size()); r++)
+    {
+        Range &range = ranges[r];
+
+        for (const string &undeclaredName : range.undeclared)
+        {
+            if (merged.lookup(undeclaredName) == nullptr) failed = true;
+        }
+
+        vector<string> names = range.symtab.getSlotNames();
+        for (const string &variableName : names)
+        {
+            long weight = range.symtab.lookup(variableName)->getAccessWeight();
+
+            SymtabEntry *entry = merged.lookup(variableName);
+            if (entry == nullptr) entry = merged.enter(variableName);
+            entry->addAccess(weight);
+
+            remaps[r].push_back(entry->getSlot());
+        }
+    }
+
+    if (failed)
+    {
+        for (Range &range : ranges) delete range.compoundNode;
+        return nullptr;
+    }
+
+    // Lay out the execution frame with the hottest variables first,
+    // as Parser does, and concatenate the statement lists.
+    vector<int> byFrequency = merged.assignSlotsByFrequency();
+
+    Node *programNode = new Node(NodeType::PROGRAM);
+    programNode->text = programName;
+
+    Node *compoundNode = new Node(COMPOUND);
+    compoundNode->lineNumber = beginLine;
+    programNode->adopt(compoundNode);
+
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        for (int &slot : remaps[r]) slot = byFrequency[slot];
+
+        Node *rangeNode = ranges[r].compoundNode;
+        for (Node *statementNode : rangeNode->children)
+        {
+            Parser::renumberSlots(statementNode, remaps[r]);
+            compoundNode->adopt(statementNode);
+        }
+
+        for (Node *leaf : ranges[r].sharedVariables)
+        {
+            leaf->slot = remaps[r][leaf->slot];
+        }
+
+        rangeNode->children.clear();
+        delete rangeNode;
+    }
+
+    *symtab = move(merged);
+    return programNode;
+}
+
+/**
+ * Find the main compound statement and the top-level semicolons in
+ * it without making tokens: skip comments and strings as the scanner
+ * does, and look only at the words that change the nesting depth.
+ * @param text the source text.
+ * @param layout set to where the parts of the program are.
+ * @return true if found, false if the source is too malformed to cut.
+ */
+bool ParallelParser::prescan(string_view text, Layout *layout)
+{
+    // The scanner takes this byte to be the end of the file.
+    if (text.find((char) EOF) != string_view::npos) return false;
+
+    size_t length = text.size();
+    size_t i = 0;
+    int depth = 0;
+    int line = 1;
+
+    while (i < length)
+    {
+        char ch = text[i];
+
+        if (ch == '\n')
+        {
+            line++;
+            i++;
+        }
+
+        // A comment or a string, whose closing character is required.
+        else if ((ch == '{') || (ch == '\''))
+        {
+            char closing = ch == '{' ? '}' : '\'';
+            size_t j = text.find(closing, i + 1);
+
+            // '' in a string is a quote character.
+            while (   (closing == '\'') && (j != string_view::npos)
+                   && (j + 1 < length) && (text[j + 1] == '\''))
+            {
+                j = text.find(closing, j + 2);
+            }
+
+            if (j == string_view::npos) return false;
+
+            line += count(text.begin() + i, text.begin() + j, '\n');
+            i = j + 1;
+        }
+
+        else if (isalpha(ch))
+        {
+            size_t j = i + 1;
+            while ((j < length) && isalnum(text[j])) j++;
+
+            switch (Token::reservedWordType(text.substr(i, j - i)))
+            {
+                case TokenType::BEGIN :
+                    if (depth++ == 0) layout->bodyStart = j;
+                    break;
+
+                case TokenType::REPEAT :
+                    if (depth++ == 0) return false;
+                    break;
+
+                case TokenType::UNTIL :
+                    if (--depth <= 0) return false;
+                    break;
+
+                case TokenType::END :
+                    if (--depth > 0) break;
+                    if (depth < 0) return false;
+
+                    layout->bodyEnd = i;
+                    layout->endLine = line;
+                    return true;
+
+                default : break;
+            }
+
+            i = j;
+        }
+
+        else
+        {
+            if ((ch == ';') && (depth == 1))
+            {
+                layout->boundaries.push_back(i + 1);
+                layout->boundaryLines.push_back(line);
+            }
+
+            i++;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Check that the program heading is exactly PROGRAM name ; BEGIN.
+ * @param text the heading's text.
+ * @param name the source's name.
+ * @param programName set to the program's name.
+ * @param beginLine set to the line number of the main BEGIN.
+ * @return true if so.
+ */
+bool ParallelParser::checkHeading(string_view text, const string &name,
+                                  string *programName, int *beginLine)
+{
+    static const TokenType expected[] =
+    {
+        TokenType::PROGRAM, IDENTIFIER, SEMICOLON, BEGIN, END_OF_FILE
+    };
+
+    StringSink errors;
+    OutputRedirect redirect(&errors);
+    Source source(text, name);
+    source.setConstantPool(constants);
+    Scanner scanner(&source);
+    bool ok = true;
+
+    for (TokenType type : expected)
+    {
+        Token *token = scanner.nextToken();
+        ok = ok && (token->type == type);
+
+        if (type == IDENTIFIER) *programName = token->text;
+        if (type == BEGIN)      *beginLine = token->lineNumber;
+        delete token;
+    }
+
+    return ok && errors.getText().empty();
+}
+
+/**
+ * Check the end of the program. The parser reads one token past the
+ * main END, which mustn't be a semicolon or an invalid token.
+ * @param text the text from the main END on.
+ * @param name the source's name.
+ * @param endLine the line number of the main END.
+ * @return true if it's all right.
+ */
+bool ParallelParser::checkEnding(string_view text, const string &name,
+                                 int endLine)
+{
+    StringSink errors;
+    OutputRedirect redirect(&errors);
+    Source source(text, name, endLine);
+    source.setConstantPool(constants);
+    Scanner scanner(&source);
+
+    Token *endToken = scanner.nextToken();
+    Token *token = scanner.nextToken();
+    bool ok =    (endToken->type == END) && (token->type != SEMICOLON)
+              && errors.getText().empty();
+
+    delete endToken;
+    delete token;
+    return ok;
+}
+
+/**
+ * Scan and parse a range of statements with its own symbol table.
+ * @param text the source text.
+ * @param name the source's name.
+ * @param range the range, which is set to the result.
+ */
+void ParallelParser::parseRange(string_view text, const string &name,
+                                Range *range)
+{
+    MemoryCounters start = MemoryCounters::forThread();
+    parseRangeText(text, name, range);
+
+    // Move the counts of this range's work from the pool thread
+    // to the range, for the calling thread to take over.
+    MemoryCounters &counters = MemoryCounters::forThread();
+    range->counts = counters.since(start);
+    counters = start;
+}
+
+/**
+ * Scan and parse the text of a range.
+ * @param text the source text.
+ * @param name the source's name.
+ * @param range the range, which is set to the result.
+ */
+void ParallelParser::parseRangeText(string_view text, const string &name,
+                                    Range *range)
+{
+    StringSink errors;
+    OutputRedirect redirect(&errors);
+
+    Source source(text.substr(range->start, range->end - range->start),
+                  name, range->firstLine);
+    source.setConstantPool(constants);
+    Scanner scanner(&source);
+    Parser parser(&scanner, &range->symtab);
+    parser.deferUndeclared(&range->undeclared);
+
+    range->compoundNode = parser.parseStatements();
+    range->sharedVariables = parser.getSharedVariables();
+    range->failed = (parser.getErrorCount() > 0) || !errors.getText().empty();
+}
+
+}  // namespace frontend
@@ -0,0 +1,109 @@
+/**
+ * Parallel parser for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef PARALLELPARSER_H_
+#define PARALLELPARSER_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../MemoryCounters.h"
+#include "../Object.h"
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Parses the top-level statements of a program on several threads.
+ * A fast pre-scan of the source characters finds the semicolons
+ * between the statements of the main compound statement by tracking
+ * the BEGIN/END and REPEAT/UNTIL depth, and the statements are cut
+ * into ranges of about equal size. Each range is scanned and parsed
+ * with its own symbol table, and then the tables are merged in source
+ * order, the variables are renumbered into the merged frame, and the
+ * statement lists are concatenated.
+ *
+ * The result is the same tree and symbol table that Parser produces.
+ * The parallel parse succeeds only for a program without any errors.
+ * Otherwise it leaves the symbol table alone and the caller parses
+ * sequentially, which reports the errors in the usual order.
+ */
+class ParallelParser
+{
+public:
+    /**
+     * Constructor.
+     * @param threadCount the number of threads to parse with.
+     */
+    ParallelParser(int threadCount)
+        : threadCount(threadCount), constants(&ConstantPool::global()) {}
+
+    /**
+     * Parse a program.
+     * @param text the source text.
+     * @param name the source's name.
+     * @param symtab the symbol table to fill in, which must be empty.
+     * @param constantPool the pool to intern the string literals in.
+     * @return the PROGRAM node, or null if the program must be
+     *         parsed sequentially instead.
+     */
+    Node *parseProgram(string_view text, const string &name, Symtab *symtab,
+                       ConstantPool *constantPool);
+
+private:
+    // Too small a program isn't worth starting threads for.
+    static const size_t MIN_PARALLEL_SIZE = 64*1024;
+
+    // Cut more ranges than threads so that they balance out.
+    static const int RANGES_PER_THREAD = 4;
+
+    /**
+     * Where the pre-scan found the parts of the program.
+     */
+    struct Layout
+    {
+        size_t bodyStart;              // just after the main BEGIN
+        size_t bodyEnd;                // at the main END
+        vector<size_t> boundaries;     // just after each top-level ;
+        vector<int> boundaryLines;     // the line number at each one
+        int endLine;                   // the line number at the main END
+    };
+
+    /**
+     * A range of top-level statements and the result of parsing it.
+     */
+    struct Range
+    {
+        size_t start, end;             // offsets into the source text
+        int firstLine;
+        Node *compoundNode = nullptr;  // the parsed statements
+        Symtab symtab;
+        vector<string> undeclared;     // names to look for in earlier ranges
+        vector<Node *> sharedVariables;  // its hash-consed VARIABLE leaves
+        MemoryCounters counts = {};    // the memory its parse used
+        bool failed = false;
+    };
+
+    int threadCount;
+    ConstantPool *constants;  // where every range interns its strings
+
+    bool prescan(string_view text, Layout *layout);
+    bool checkHeading(string_view text, const string &name,
+                      string *programName, int *beginLine);
+    bool checkEnding(string_view text, const string &name, int endLine);
+    void parseRange(string_view text, const string &name, Range *range);
+    void parseRangeText(string_view text, const string &name, Range *range);
+};
+
+}  // namespace frontend
+
+#endif /* PARALLELPARSER_H_ */
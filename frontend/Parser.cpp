@@ -6,8 +6,10 @@
  * San Jose State University
  */
 #include <string>
-#include <map>
+#include <string.h>
 
+#include "../Output.h"
+#include "../MemoryCounters.h"
 #include "Token.h"
 #include "Parser.h"
 
@@ -15,55 +17,35 @@ namespace frontend {
 
 using namespace std;
 
-set<TokenType> Parser::statementStarters;
-set<TokenType> Parser::statementFollowers;
-set<TokenType> Parser::relationalOperators;
-set<TokenType> Parser::simpleExpressionOperators;
-set<TokenType> Parser::termOperators;
-set<TokenType> Parser::factorOperators;
-
-void Parser::initialize()
+Parser::~Parser()
 {
-    // Tokens that can start a statement.
-    statementStarters.insert(BEGIN);
-    statementStarters.insert(IDENTIFIER);
-    statementStarters.insert(REPEAT);
-    statementStarters.insert(WHILE);
-    statementStarters.insert(TokenType::WRITE);
-    statementStarters.insert(TokenType::WRITELN);
-
-    // Tokens that can immediately follow a statement.
-    statementFollowers.insert(SEMICOLON);
-    statementFollowers.insert(END);
-    statementFollowers.insert(UNTIL);
-    statementFollowers.insert(END_OF_FILE);
-    statementFollowers.insert(DO);
-
-    relationalOperators.insert(EQUALS);
-    relationalOperators.insert(LESS_THAN);
-    relationalOperators.insert(LESS_EQUALS);
-    relationalOperators.insert(GREATER_THAN);
-    relationalOperators.insert(GREATER_EQUALS);
-    relationalOperators.insert(NOT_EQUALS);
-
-    simpleExpressionOperators.insert(PLUS);
-    simpleExpressionOperators.insert(MINUS);
-
-    termOperators.insert(STAR);
-    termOperators.insert(SLASH);
-
-    factorOperators.insert(TokenType::NOT);
+    delete currentToken;
+
+    // Give up the parser's shares of the hash-consed leaves.
+    for (auto &entry : integerLeaves)  Node::release(entry.second);
+    for (auto &entry : realLeaves)     Node::release(entry.second);
+    for (auto &entry : variableLeaves) Node::release(entry.second);
 }
 
 Node *Parser::parseProgram()
+{
+    return parseProgram(nullptr);
+}
+
+Node *Parser::parseProgram(const StatementHandler &handler)
+{
+    return parseProgram(&handler);
+}
+
+Node *Parser::parseProgram(const StatementHandler *handler)
 {
     Node *programNode = new Node(NodeType::PROGRAM);
 
-    currentToken = scanner->nextToken();  // first token!
+    nextToken();  // first token!
 
     if (currentToken->type == TokenType::PROGRAM)
     {
-        currentToken = scanner->nextToken();  // consume PROGRAM
+        nextToken();  // consume PROGRAM
     }
     else syntaxError("Expecting PROGRAM");
 
@@ -73,25 +55,51 @@ Node *Parser::parseProgram()
         symtab->enter(programName);
         programNode->text = programName;
 
-        currentToken = scanner->nextToken();  // consume program name
+        nextToken();  // consume program name
     }
     else syntaxError("Expecting program name");
 
     if (currentToken->type == SEMICOLON)
     {
-        currentToken = scanner->nextToken();  // consume ;
+        nextToken();  // consume ;
     }
     else syntaxError("Missing ;");
 
     if (currentToken->type != BEGIN) syntaxError("Expecting BEGIN");
 
     // The PROGRAM node adopts the COMPOUND tree.
-    programNode->adopt(parseCompoundStatement());
+    programNode->adopt(parseCompoundStatement(handler));
+    if (stopped) return programNode;
 
     if (currentToken->type == SEMICOLON) syntaxError("Expecting .");
+
+    // Lay out the execution frame with the hottest variables first.
+    // Streamed statements have already used their slots.
+    if ((errorCount == 0) && (handler == nullptr))
+    {
+        vector<int> remap = symtab->assignSlotsByFrequency();
+
+        renumberSlots(programNode, remap);
+        for (auto &entry : variableLeaves)
+        {
+            entry.second->slot = remap[entry.second->slot];
+        }
+    }
+
     return programNode;
 }
 
+Node *Parser::parseStatements()
+{
+    nextToken();  // first token!
+
+    Node *compoundNode = new Node(COMPOUND);
+    compoundNode->lineNumber = currentToken->lineNumber;
+    parseStatementList(compoundNode, END_OF_FILE);
+
+    return compoundNode;
+}
+
 Node *Parser::parseStatement()
 {
 //	cout << "parse statement : " << currentToken->text << " : " << currentToken->lineNumber << endl;
@@ -126,20 +134,18 @@ Node *Parser::parseAssignmentStatement()
     // Enter the variable name into the symbol table
     // if it isn't already in there.
     string variableName = currentToken->text;
-    SymtabEntry *variableId = symtab->lookup(toLowerCase(variableName));
+    SymtabEntry *variableId = symtab->lookup(variableName);
     if (variableId == nullptr) variableId = symtab->enter(variableName);
+    variableId->addAccess(accessWeight());
 
     // The assignment node adopts the variable node as its first child.
-    Node *lhsNode  = new Node(VARIABLE);
-    lhsNode->text  = variableName;
-    lhsNode->entry = variableId;
-    assignmentNode->adopt(lhsNode);
+    assignmentNode->adopt(variableLeaf(variableName, variableId->getSlot()));
 
-    currentToken = scanner->nextToken();  // consume the LHS variable;
+    nextToken();  // consume the LHS variable;
 
     if (currentToken->type == COLON_EQUALS)
     {
-        currentToken = scanner->nextToken();  // consume :=
+        nextToken();  // consume :=
     }
     else syntaxError("Missing :=");
 
@@ -150,18 +156,19 @@ Node *Parser::parseAssignmentStatement()
     return assignmentNode;
 }
 
-Node *Parser::parseCompoundStatement()
+Node *Parser::parseCompoundStatement(const StatementHandler *handler)
 {
 //	cout << "parse compound statement" << endl;
     Node *compoundNode = new Node(COMPOUND);
     compoundNode->lineNumber = currentToken->lineNumber;
 
-    currentToken = scanner->nextToken();  // consume BEGIN
-    parseStatementList(compoundNode, END);
+    nextToken();  // consume BEGIN
+    parseStatementList(compoundNode, END, handler);
+    if (stopped) return compoundNode;
 
     if (currentToken->type == END)
     {
-        currentToken = scanner->nextToken();  // consume END
+        nextToken();  // consume END
 //        cout << "should be current token end : " << currentToken->text << endl;
     }
     else syntaxError("Expecting END");
@@ -169,24 +176,43 @@ Node *Parser::parseCompoundStatement()
     return compoundNode;
 }
 
-void Parser::parseStatementList(Node *parentNode, TokenType terminalType)
+void Parser::parseStatementList(Node *parentNode, TokenType terminalType,
+                                const StatementHandler *handler)
 {
     while (   (currentToken->type != terminalType)
            && (currentToken->type != END_OF_FILE))
     {
+        // A statement follower that doesn't end this list can't start
+        // a statement either. Skip it rather than stall on it forever.
+        if (   (currentToken->type != SEMICOLON)
+            && statementFollowers.contains(currentToken->type))
+        {
+            lineNumber = currentToken->lineNumber;
+            syntaxError("Unexpected token");
+            nextToken();
+            continue;
+        }
+
         Node *stmtNode = parseStatement();
-        if (stmtNode != nullptr) parentNode->adopt(stmtNode);
+        if (stmtNode != nullptr)
+        {
+            if (handler == nullptr) parentNode->adopt(stmtNode);
+            else if (!(*handler)(stmtNode))
+            {
+                stopped = true;
+                return;
+            }
+        }
 
         // A semicolon separates statements.
         if (currentToken->type == SEMICOLON)
         {
             while (currentToken->type == SEMICOLON)
             {
-                currentToken = scanner->nextToken();  // consume ;
+                nextToken();  // consume ;
             }
         }
-        else if (statementStarters.find(currentToken->type) !=
-                                                        statementStarters.end())
+        else if (statementStarters.contains(currentToken->type))
         {
             syntaxError("Missing ;");
         }
@@ -200,7 +226,8 @@ Node *Parser::parseRepeatStatement()
     // Create a LOOP node.
     Node *loopNode = new Node(LOOP);
 //    cout << "start of repeat" << endl;
-    currentToken = scanner->nextToken();  // consume REPEAT
+    nextToken();  // consume REPEAT
+    loopDepth++;
 
     parseStatementList(loopNode, UNTIL);
 
@@ -211,7 +238,7 @@ Node *Parser::parseRepeatStatement()
         Node *testNode = new Node(TEST);
         lineNumber = currentToken->lineNumber;
         testNode->lineNumber = lineNumber;
-        currentToken = scanner->nextToken();  // consume UNTIL
+        nextToken();  // consume UNTIL
         testNode->adopt(parseExpression());
 
         // The LOOP node adopts the TEST node as its final child.
@@ -219,6 +246,7 @@ Node *Parser::parseRepeatStatement()
     }
     else syntaxError("Expecting UNTIL");
 
+    loopDepth--;
     return loopNode;
 }
 
@@ -229,7 +257,8 @@ Node *Parser::parseWhileStatement()
 
 	// Create LOOP node
 	Node *loopNode = new Node(LOOP);
-	currentToken = scanner->nextToken();  // consume WHILE
+	nextToken();  // consume WHILE
+	loopDepth++;
 
 	// Create TEST node
 //	cout << "creating test : " << currentToken->text << endl;
@@ -251,7 +280,7 @@ Node *Parser::parseWhileStatement()
 	if (currentToken->type == DO)
 	{
 //		cout << "current token type is do" << endl;
-		currentToken = scanner->nextToken(); // consume DO
+		nextToken(); // consume DO
 //		cout << "token after DO : " << currentToken->text << endl;
 		loopNode->adopt(parseStatement());
 	}
@@ -262,6 +291,7 @@ Node *Parser::parseWhileStatement()
 		syntaxError("Expecting DO");
 	}
 
+	loopDepth--;
 	return loopNode;
 
 }
@@ -272,7 +302,7 @@ Node *Parser::parseWriteStatement()
 
     // Create a WRITE node-> It adopts the variable or string node.
     Node *writeNode = new Node(NodeType::WRITE);
-    currentToken = scanner->nextToken();  // consume WRITE
+    nextToken();  // consume WRITE
 
     parseWriteArguments(writeNode);
     if (writeNode->children.size() == 0)
@@ -289,7 +319,7 @@ Node *Parser::parseWritelnStatement()
 
     // Create a WRITELN node. It adopts the variable or string node.
     Node *writelnNode = new Node(NodeType::WRITELN);
-    currentToken = scanner->nextToken();  // consume WRITELN
+    nextToken();  // consume WRITELN
 
     if (currentToken->type == LPAREN) parseWriteArguments(writelnNode);
     return writelnNode;
@@ -305,7 +335,7 @@ void Parser::parseWriteArguments(Node *node)
 
     if (currentToken->type == LPAREN)
     {
-        currentToken = scanner->nextToken();  // consume after (
+        nextToken();  // consume after (
 //        cout << "consume after ( : " << currentToken->text << endl;
     }
     else syntaxError("Missing left parenthesis");
@@ -330,7 +360,7 @@ void Parser::parseWriteArguments(Node *node)
     {
         if (currentToken->type == COLON)
         {
-            currentToken = scanner->nextToken();  // consume ,
+            nextToken();  // consume ,
 
             if (currentToken->type == INTEGER)
             {
@@ -339,7 +369,7 @@ void Parser::parseWriteArguments(Node *node)
 
                 if (currentToken->type == COLON)
                 {
-                    currentToken = scanner->nextToken();  // consume ,
+                    nextToken();  // consume ,
 
                     if (currentToken->type == INTEGER)
                     {
@@ -355,7 +385,7 @@ void Parser::parseWriteArguments(Node *node)
 
     if (currentToken->type == RPAREN)
     {
-        currentToken = scanner->nextToken();  // consume )
+        nextToken();  // consume )
     }
     else syntaxError("Missing right parenthesis");
 }
@@ -363,92 +393,42 @@ void Parser::parseWriteArguments(Node *node)
 Node *Parser::parseExpression()
 {
     // The current token should now be an identifier or a number.
-
-    // The expression's root node->
-    Node *exprNode = parseSimpleExpression();
-
-    // The current token might now be a relational operator.
-    if (relationalOperators.find(currentToken->type) != relationalOperators.end())
-    {
-        TokenType tokenType = currentToken->type;
-//        cout << "parse expression : " << currentToken->text << " : " << currentToken->lineNumber << endl;
-        Node *opNode = tokenType == EQUALS    ? new Node(EQ)
-                    : tokenType == LESS_THAN ? new Node(LT)
-        			: tokenType == LESS_EQUALS ? new Node(LE)
-        			: tokenType == GREATER_THAN ? new Node(GT)
-        			: tokenType == GREATER_EQUALS ? new Node(GE)
-        			: tokenType == NOT_EQUALS ? new Node(NE)
-                    :                          nullptr;
-
-        currentToken = scanner->nextToken();  // consume relational operator
-
-        // The relational operator node adopts the first simple expression
-        // node as its first child and the second simple expression node
-        // as its second child. Then it becomes the expression's root node.
-        if (opNode != nullptr)
-        {
-            opNode->adopt(exprNode);
-            opNode->adopt(parseSimpleExpression());
-            exprNode = opNode;
-        }
-    }
-
-    return exprNode;
+    return parseOperands(BindingPowerTable::NO_OPERATOR);
 }
 
-Node *Parser::parseSimpleExpression()
+/**
+ * Parse operands joined by binary operators that bind tighter than
+ * a given binding power, by precedence climbing. This builds the
+ * same left-associative tree as parsing an expression, then simple
+ * expressions, then terms, then factors, but each operand costs one
+ * call and one table lookup of the token after it.
+ * @param minPower the binding power.
+ * @return the root of the subtree.
+ */
+Node *Parser::parseOperands(int minPower)
 {
-    // The current token should now be an identifier or a number.
-
-    // The simple expression's root node->
-    Node *simpExprNode = parseTerm();
+    Node *leftNode = parseFactor();
 
-    // Keep parsing more terms as long as the current token
-    // is a + or - operator.
-    while (simpleExpressionOperators.find(currentToken->type) !=
-                                                simpleExpressionOperators.end())
+    for (;;)
     {
-        Node *opNode = currentToken->type == PLUS ? new Node(ADD)
-                                                : new Node(SUBTRACT);
+        const BindingPowerTable::Entry &op = bindingPowers[currentToken->type];
+        if (op.power <= minPower) break;
 
-        currentToken = scanner->nextToken();  // consume the operator
+        Node *opNode = new Node(op.nodeType);
+        nextToken();  // consume the operator
 
-        // The add or subtract node adopts the first term node as its
-        // first child and the next term node as its second child.
-        // Then it becomes the simple expression's root node.
-        opNode->adopt(simpExprNode);
-        opNode->adopt(parseTerm());
-        simpExprNode = opNode;
-    }
-
-    return simpExprNode;
-}
+        // The operator node adopts the left operand as its first child
+        // and the tighter-binding operands to its right as its second
+        // child. Then it becomes the left operand of the next operator.
+        opNode->adopt(leftNode);
+        opNode->adopt(parseOperands(op.power));
+        leftNode = opNode;
 
-Node *Parser::parseTerm()
-{
-    // The current token should now be an identifier or a number.
-
-    // The term's root node->
-    Node *termNode = parseFactor();
-
-    // Keep parsing more factors as long as the current token
-    // is a * or / operator.
-    while (termOperators.find(currentToken->type) != termOperators.end())
-    {
-        Node *opNode = currentToken->type == STAR ? new Node(MULTIPLY)
-                                                : new Node(DIVIDE);
-
-        currentToken = scanner->nextToken();  // consume the operator
-
-        // The multiply or divide node adopts the first factor node as its
-        // as its first child and the next factor node as its second child.
-        // Then it becomes the term's root node.
-        opNode->adopt(termNode);
-        opNode->adopt(parseFactor());
-        termNode = opNode;
+        // a < b < c isn't an expression.
+        if (op.power == BindingPowerTable::RELATIONAL) break;
     }
 
-    return termNode;
+    return leftNode;
 }
 
 Node *Parser::parseFactor()
@@ -461,12 +441,12 @@ Node *Parser::parseFactor()
 
     else if (currentToken->type == LPAREN)
     {
-        currentToken = scanner->nextToken();  // consume (
+        nextToken();  // consume (
         Node *exprNode = parseExpression();
 
         if (currentToken->type == RPAREN)
         {
-            currentToken = scanner->nextToken();  // consume )
+            nextToken();  // consume )
         }
         else syntaxError("Expecting )");
 
@@ -483,14 +463,28 @@ Node *Parser::parseVariable()
 
     // Has the variable been "declared"?
     string variableName = currentToken->text;
-    SymtabEntry *variableId = symtab->lookup(toLowerCase(variableName));
+    SymtabEntry *variableId = symtab->lookup(variableName);
+    if ((variableId == nullptr) && (undeclared != nullptr))
+    {
+        undeclared->push_back(variableName);
+        variableId = symtab->enter(variableName);
+    }
+
     if (variableId == nullptr) semanticError("Undeclared identifier");
+    else                       variableId->addAccess(accessWeight());
 
-    Node *node  = new Node(VARIABLE);
-    node->text  = variableName;
-    node->entry = variableId;
+    Node *node;
+    if (variableId != nullptr)
+    {
+        node = variableLeaf(variableName, variableId->getSlot());
+    }
+    else
+    {
+        node = new Node(VARIABLE);
+        node->text = variableName;
+    }
 
-    currentToken = scanner->nextToken();  // consume the identifier
+    nextToken();  // consume the identifier
     return node;
 }
 
@@ -498,22 +492,36 @@ Node *Parser::parseIntegerConstant()
 {
     // The current token should now be a number.
 
-    Node *integerNode = new Node(INTEGER_CONSTANT);
-    integerNode->value = currentToken->value;
+    Node *&integerNode = integerLeaves[currentToken->value.L()];
+    if (integerNode == nullptr)
+    {
+        integerNode = new Node(INTEGER_CONSTANT);
+        integerNode->value = currentToken->value;
+        integerNode->sharers = 1;  // the parser's share
+    }
 
-    currentToken = scanner->nextToken();  // consume the number
-    return integerNode;
+    nextToken();  // consume the number
+    return shareLeaf(integerNode);
 }
 
 Node *Parser::parseRealConstant()
 {
     // The current token should now be a number.
 
-    Node *realNode = new Node(REAL_CONSTANT);
-    realNode->value = currentToken->value;
+    double value = currentToken->value.D();
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    Node *&realNode = realLeaves[bits];
+    if (realNode == nullptr)
+    {
+        realNode = new Node(REAL_CONSTANT);
+        realNode->value = currentToken->value;
+        realNode->sharers = 1;  // the parser's share
+    }
 
-    currentToken = scanner->nextToken();  // consume the number
-    return realNode;
+    nextToken();  // consume the number
+    return shareLeaf(realNode);
 }
 
 Node *Parser::parseStringConstant()
@@ -523,30 +531,92 @@ Node *Parser::parseStringConstant()
     Node *stringNode = new Node(STRING_CONSTANT);
     stringNode->value = currentToken->value;
 
-    currentToken = scanner->nextToken();  // consume the string
+    nextToken();  // consume the string
     return stringNode;
 }
 
+/**
+ * Get the hash-consed leaf of a variable.
+ * @param name the variable's name as spelled.
+ * @param slot its frame slot.
+ * @return the leaf.
+ */
+Node *Parser::variableLeaf(const string &name, int slot)
+{
+    Node *&variableNode = variableLeaves[name];
+    if (variableNode == nullptr)
+    {
+        variableNode = new Node(VARIABLE);
+        variableNode->text = name;
+        variableNode->slot = slot;
+        variableNode->sharers = 1;  // the parser's share
+    }
+
+    return shareLeaf(variableNode);
+}
+
+/**
+ * Give a hash-consed leaf one more owner.
+ * @param leaf the leaf.
+ * @return the leaf.
+ */
+Node *Parser::shareLeaf(Node *leaf)
+{
+    // Count each node that a parent shares instead of allocating.
+    if (leaf->sharers > 1) MemoryCounters::forThread().sharedNodes++;
+
+    leaf->sharers++;
+    return leaf;
+}
+
+void Parser::nextToken()
+{
+    delete currentToken;  // the parser owns the tokens it has consumed
+    currentToken = scanner->nextToken();
+}
+
+long Parser::accessWeight() const
+{
+    // Assume each enclosing loop runs about eight times as often
+    // as the code around it. Cap the weight to avoid overflow.
+    return 1L << (3*min(loopDepth, 16));
+}
+
+vector<Node *> Parser::getSharedVariables() const
+{
+    vector<Node *> leaves;
+    for (auto &entry : variableLeaves) leaves.push_back(entry.second);
+
+    return leaves;
+}
+
+void Parser::renumberSlots(Node *node, const vector<int> &remap)
+{
+    if (node->sharers > 0) return;  // renumbered separately
+
+    if (node->slot >= 0) node->slot = remap[node->slot];
+    for (Node *child : node->children) renumberSlots(child, remap);
+}
+
 void Parser::syntaxError(string message)
 {
-    printf("SYNTAX ERROR at line %d: %s at '%s'\n",
-           lineNumber, message.c_str(), currentToken->text.c_str());
+    output().print("SYNTAX ERROR at line %d: %s at '%s'\n",
+                   lineNumber, message.c_str(), currentToken->text.c_str());
     errorCount++;
 
     // Recover by skipping the rest of the statement.
     // Skip to a statement follower token.
-    while (statementFollowers.find(currentToken->type) ==
-                                                    statementFollowers.end())
+    while (!statementFollowers.contains(currentToken->type))
     {
-        currentToken = scanner->nextToken();
+        nextToken();
     }
 //    exit(-1);
 }
 
 void Parser::semanticError(string message)
 {
-    printf("SEMANTIC ERROR at line %d: %s at '%s'\n",
-           lineNumber, message.c_str(), currentToken->text.c_str());
+    output().print("SEMANTIC ERROR at line %d: %s at '%s'\n",
+                   lineNumber, message.c_str(), currentToken->text.c_str());
     errorCount++;
 }
 
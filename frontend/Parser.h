@@ -8,8 +8,11 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
-#include <set>
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
 
+#include "../EnumSet.h"
 #include "Scanner.h"
 #include "Token.h"
 #include "../intermediate/Symtab.h"
@@ -20,56 +23,189 @@ namespace frontend {
 using namespace std;
 using namespace intermediate;
 
+/**
+ * The binding power and node type of each token type as a binary
+ * operator, for parsing expressions by precedence climbing.
+ * It's built at compile time.
+ */
+class BindingPowerTable
+{
+public:
+    // Binding powers from loosest to tightest.
+    // Relational operators don't associate.
+    static const int NO_OPERATOR    = 0;
+    static const int RELATIONAL     = 1;
+    static const int ADDITIVE       = 2;
+    static const int MULTIPLICATIVE = 3;
+
+    struct Entry
+    {
+        int power;          // NO_OPERATOR if the token isn't an operator
+        NodeType nodeType;  // the operator's node type
+    };
+
+    constexpr BindingPowerTable()
+    {
+        set(TokenType::EQUALS,         RELATIONAL,     EQ);
+        set(TokenType::NOT_EQUALS,     RELATIONAL,     NE);
+        set(TokenType::LESS_THAN,      RELATIONAL,     LT);
+        set(TokenType::LESS_EQUALS,    RELATIONAL,     LE);
+        set(TokenType::GREATER_THAN,   RELATIONAL,     GT);
+        set(TokenType::GREATER_EQUALS, RELATIONAL,     GE);
+        set(TokenType::PLUS,           ADDITIVE,       ADD);
+        set(TokenType::MINUS,          ADDITIVE,       SUBTRACT);
+        set(TokenType::STAR,           MULTIPLICATIVE, MULTIPLY);
+        set(TokenType::SLASH,          MULTIPLICATIVE, DIVIDE);
+    }
+
+    constexpr const Entry &operator [](TokenType type) const
+    {
+        return entries[(int) type];
+    }
+
+private:
+    Entry entries[(int) TokenType::ERROR + 1] = {};
+
+    constexpr void set(TokenType type, int power, NodeType nodeType)
+    {
+        entries[(int) type] = Entry{power, nodeType};
+    }
+};
+
 class Parser
 {
+public:
+    /**
+     * Takes over a top-level statement as soon as it's parsed.
+     * Returns false to stop parsing.
+     */
+    typedef function<bool(Node *)> StatementHandler;
+
 private:
     Scanner *scanner;
     Symtab *symtab;
     Token *currentToken;
     int lineNumber;
     int errorCount;
+    int loopDepth;  // how many loops enclose the current statement
+    bool stopped;   // did a statement handler stop the parse?
+    vector<string> *undeclared;  // where to defer undeclared names, or null
 
-    static set<TokenType> statementStarters;          // what starts a statement
-    static set<TokenType> statementFollowers;         // what follows a statement
-    static set<TokenType> relationalOperators;        // relational operators
-    static set<TokenType> simpleExpressionOperators;  // simple expression operators
-    static set<TokenType> termOperators;              // term operators
-    static set<TokenType> factorOperators;
+    // Hash-consed leaves: every use of the same constant or variable
+    // shares one immutable node, which the parser holds a share of.
+    unordered_map<long, Node *> integerLeaves;
+    unordered_map<uint64_t, Node *> realLeaves;  // by the value's bits
+    unordered_map<string, Node *> variableLeaves;
 
-public:
-    /**
-     * Initialize the static sets.
-     */
-    static void initialize();
+    // What starts a statement.
+    static constexpr EnumSet<TokenType> statementStarters =
+    {
+        TokenType::BEGIN, TokenType::IDENTIFIER, TokenType::REPEAT,
+        TokenType::WHILE, TokenType::WRITE, TokenType::WRITELN
+    };
+
+    // What follows a statement.
+    static constexpr EnumSet<TokenType> statementFollowers =
+    {
+        TokenType::SEMICOLON, TokenType::END, TokenType::UNTIL,
+        TokenType::END_OF_FILE, TokenType::DO
+    };
+
+    // The binding power and node type of each binary operator.
+    static constexpr BindingPowerTable bindingPowers = BindingPowerTable();
+
+    // Factor operators.
+    static constexpr EnumSet<TokenType> factorOperators =
+    {
+        TokenType::NOT
+    };
 
+public:
     Parser(Scanner *scanner, Symtab *symtab)
         : scanner(scanner), symtab(symtab), currentToken(nullptr),
-          lineNumber(1), errorCount(0) {}
+          lineNumber(1), errorCount(0), loopDepth(0), stopped(false),
+          undeclared(nullptr) {}
+
+    ~Parser();
 
     int getErrorCount() const { return errorCount; }
 
+    /**
+     * Collect the names of undeclared variables instead of reporting
+     * them, e.g. when parsing a part of a program whose earlier parts
+     * may declare them. Each such name is entered into the symbol table
+     * at its first use.
+     * @param names where to append the names in order of first use.
+     */
+    void deferUndeclared(vector<string> *names) { undeclared = names; }
+
+    /**
+     * Change the frame slots of the variables in a tree. A walk reaches
+     * a hash-consed leaf once per owner, so it skips them: renumber
+     * each of the parser's shared variables once instead.
+     * @param node the root of the tree.
+     * @param remap a table that maps each old slot index to its new one.
+     */
+    static void renumberSlots(Node *node, const vector<int> &remap);
+
+    /**
+     * Getter.
+     * @return the hash-consed VARIABLE leaves of the trees parsed so far.
+     */
+    vector<Node *> getSharedVariables() const;
+
     Node *parseProgram();
 
+    /**
+     * Parse a program, but hand each statement of its main compound
+     * statement to a handler as soon as it's parsed instead of adding
+     * it to the tree, so the whole tree is never in memory at once.
+     * Variables keep the slots the symbol table gave them in order of
+     * appearance, since they can't be renumbered after the fact.
+     * @param handler the handler, which owns each statement it's given.
+     * @return the PROGRAM node, whose COMPOUND node has no statements.
+     */
+    Node *parseProgram(const StatementHandler &handler);
+
+    /**
+     * Parse a sequence of statements that make up the entire source,
+     * such as a line entered interactively. Variables keep the slots
+     * the symbol table gave them, so that a context built up by
+     * earlier sequences remains valid.
+     * @return a COMPOUND node that holds the statements.
+     */
+    Node *parseStatements();
+
 private:
     Node *parseStatement();
     Node *parseAssignmentStatement();
-    Node *parseCompoundStatement();
+    Node *parseCompoundStatement(const StatementHandler *handler = nullptr);
     Node *parseRepeatStatement();
     Node *parseWhileStatement();
     Node *parseWriteStatement();
     Node *parseWritelnStatement();
     Node *parseExpression();
-    Node *parseSimpleExpression();
-    Node *parseTerm();
+    Node *parseOperands(int minPower);
     Node *parseFactor();
     Node *parseVariable();
     Node *parseIntegerConstant();
     Node *parseRealConstant();
     Node *parseStringConstant();
+    Node *variableLeaf(const string &name, int slot);
+    Node *shareLeaf(Node *leaf);
 
-    void parseStatementList(Node *parentNode, TokenType terminalType);
+    /**
+     * Consume the current token and get the next one from the scanner.
+     */
+    void nextToken();
+
+    void parseStatementList(Node *parentNode, TokenType terminalType,
+                            const StatementHandler *handler = nullptr);
+    Node *parseProgram(const StatementHandler *handler);
     void parseWriteArguments(Node *node);
 
+    long accessWeight() const;
+
     void syntaxError(string message);
     void semanticError(string message);
 };
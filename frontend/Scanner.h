@@ -8,6 +8,13 @@
 #ifndef SCANNER_H_
 #define SCANNER_H_
 
+#include <string>
+#include <vector>
+#include <thread>
+#include <utility>
+
+#include "../Output.h"
+#include "../SpscQueue.h"
 #include "Source.h"
 #include "Token.h"
 
@@ -18,20 +25,194 @@ using namespace std;
 class Scanner
 {
 private:
+    /**
+     * Tokens scanned ahead, with the messages of any token errors
+     * to print as each one is handed out.
+     */
+    struct TokenBatch
+    {
+        vector<Token *> tokens;
+        vector<pair<size_t, string>> errors;  // {token index, message}
+    };
+
+    static const size_t BATCH_SIZE  = 512;  // tokens per pipelined batch
+    static const size_t QUEUE_DEPTH = 16;   // batches in flight
+
     Source *source;
+    TokenBatch buffer;       // tokens scanned ahead
+    size_t next;             // index of the next buffered token
+    size_t nextError;        // index of the next buffered error
+    SpscQueue<TokenBatch> *queue;  // batches from the scanning thread
+    thread scanningThread;
+    bool scannedAll;         // has the end-of-file token been buffered?
 
 public:
     /**
      * Constructor.
      * @param source the input source.
      */
-    Scanner(Source *source) : source(source) {}
+    Scanner(Source *source)
+        : source(source), next(0), nextError(0), queue(nullptr),
+          scannedAll(false) {}
+
+    /**
+     * Destructor. Whoever calls nextToken() owns the token it returns,
+     * so this deletes only the buffered tokens never handed out.
+     */
+    ~Scanner()
+    {
+        if (queue != nullptr)
+        {
+            // The parser may stop before the end of the source.
+            queue->close();
+            if (scanningThread.joinable()) scanningThread.join();
+
+            TokenBatch batch;
+            while (queue->pop(batch))
+            {
+                for (Token *token : batch.tokens) delete token;
+            }
+
+            delete queue;
+        }
+
+        while (next < buffer.tokens.size()) delete buffer.tokens[next++];
+    }
+
+    /**
+     * Scan the whole source now, through the end-of-file token.
+     * nextToken() will then hand out the buffered tokens. This lets
+     * scanning be measured separately from parsing. As with pipeline(),
+     * any token error message is printed only when its token is
+     * handed out.
+     */
+    void scanAll()
+    {
+        StringSink errors;
+        OutputRedirect redirect(&errors);
+
+        Token *token;
+        do
+        {
+            token = scanToken();
+
+            if (!errors.getText().empty())
+            {
+                buffer.errors.emplace_back(buffer.tokens.size(),
+                                           errors.getText());
+                errors.clear();
+            }
+
+            buffer.tokens.push_back(token);
+        } while (token->type != END_OF_FILE);
+
+        scannedAll = true;
+    }
+
+    /**
+     * Scan the source on a thread of its own from now on, while the
+     * caller consumes the tokens with nextToken() concurrently. The
+     * tokens arrive in batches through a bounded queue, and any token
+     * error message is printed only when its token is handed out, so
+     * the output is the same as when scanning as the parser goes.
+     */
+    void pipeline()
+    {
+        queue = new SpscQueue<TokenBatch>(QUEUE_DEPTH);
+        scanningThread = thread(&Scanner::scanAhead, this);
+    }
 
     /**
      * Extract the next token from the source.
      * @return the token.
      */
     Token *nextToken()
+    {
+        if ((next == buffer.tokens.size()) && (queue != nullptr))
+        {
+            nextBatch();
+        }
+
+        if (next < buffer.tokens.size())
+        {
+            if (   (nextError < buffer.errors.size())
+                && (buffer.errors[nextError].first == next))
+            {
+                output().write(buffer.errors[nextError++].second);
+            }
+
+            return buffer.tokens[next++];
+        }
+
+        return scanToken();
+    }
+
+private:
+    /**
+     * The scanning thread: scan the whole source into batches,
+     * capturing the token error messages instead of printing them.
+     */
+    void scanAhead()
+    {
+        StringSink errors;
+        OutputRedirect redirect(&errors);
+
+        TokenBatch batch;
+        bool atEnd;
+        do
+        {
+            Token *token = scanToken();
+
+            if (!errors.getText().empty())
+            {
+                batch.errors.emplace_back(batch.tokens.size(),
+                                          errors.getText());
+                errors.clear();
+            }
+
+            // Once it's pushed, the token belongs to the parser.
+            atEnd = token->type == END_OF_FILE;
+            batch.tokens.push_back(token);
+
+            if ((batch.tokens.size() == BATCH_SIZE) || atEnd)
+            {
+                if (!queue->push(move(batch)))
+                {
+                    for (Token *unwanted : batch.tokens) delete unwanted;
+                    return;
+                }
+
+                batch = TokenBatch();
+            }
+        } while (!atEnd);
+    }
+
+    /**
+     * Replace the used-up buffer with the next batch from the
+     * scanning thread. After the end-of-file token, the thread is
+     * done and any further tokens are scanned here as usual.
+     */
+    void nextBatch()
+    {
+        if (scannedAll)
+        {
+            if (scanningThread.joinable()) scanningThread.join();
+            return;
+        }
+
+        buffer.tokens.clear();
+        buffer.errors.clear();
+        next = nextError = 0;
+
+        queue->pop(buffer);
+        scannedAll = buffer.tokens.back()->type == END_OF_FILE;
+    }
+
+    /**
+     * Scan the next token from the source.
+     * @return the token.
+     */
+    Token *scanToken()
     {
         // Skip blanks, comments, and other whitespace characters.
         char ch = nextNonblankCharacter();
@@ -42,7 +223,6 @@ public:
         else                  return Token::SpecialSymbol(ch, source);
     }
 
-private:
     /**
      * Skip blanks, comments, and other whitespace characters
      * and return the next nonblank character.
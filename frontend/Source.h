@@ -9,20 +9,49 @@
 #define SOURCE_H_
 
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <string_view>
+#include <stdexcept>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Object.h"
 
 namespace frontend {
 
 using namespace std;
 
+/**
+ * Thrown when the source file can't be opened or read.
+ */
+class SourceError : public runtime_error
+{
+public:
+    SourceError(const string &message) : runtime_error(message) {}
+};
+
+/**
+ * The source program text. A regular source file is memory-mapped
+ * rather than read through a stream, a pipe is read into memory, and
+ * source text can also come straight from memory, e.g. from a socket.
+ */
 class Source
 {
 private:
-    ifstream source;
     string sourceFileName;
-    int  lineNum;      // current source line number
-    char currentCh;    // current source character
+    ConstantPool *constants;  // where to intern string literals
+    string text;         // the source text, if it wasn't mapped
+    void *mapping;       // the mapped source file, or null
+    size_t mappedSize;
+    const char *start;   // the start of the source text
+    const char *next;    // the next source character to read
+    const char *end;     // the end of the source text
+    int  lineNum;        // current source line number
+    char currentCh;      // current source character
 
 public:
     static const char EOL = '\n';
@@ -30,26 +59,141 @@ public:
     /**
      * Constructor
      * @param sourceFileName the source file name.
+     * @throw SourceError if the file can't be opened or read.
      */
-    Source(string sourceFileName) : lineNum(1)
+    Source(string sourceFileName)
+        : sourceFileName(sourceFileName),
+          constants(&ConstantPool::global()), mapping(nullptr), mappedSize(0),
+          start(nullptr), next(nullptr), end(nullptr), lineNum(1)
     {
-        source.open(sourceFileName);
+        int fd = open(sourceFileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw SourceError("*** ERROR: Failed to open " + sourceFileName);
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) < 0)
+        {
+            close(fd);
+            throw SourceError("*** ERROR: Failed to read " + sourceFileName);
+        }
+
+        // A pipe or other stream has no size to map, so read it all.
+        if (!S_ISREG(status.st_mode))
+        {
+            char chunk[65536];
+            ssize_t count;
+            while ((count = read(fd, chunk, sizeof(chunk))) != 0)
+            {
+                if (count > 0) text.append(chunk, count);
+                else if (errno != EINTR)
+                {
+                    close(fd);
+                    throw SourceError("*** ERROR: Failed to read "
+                                      + sourceFileName);
+                }
+            }
+
+            start = text.data();
+            next  = start;
+            end   = start + text.size();
+        }
 
-        if (source.fail())
+        else if (status.st_size > 0)
         {
-            cout << "*** ERROR: Failed to open " << sourceFileName << endl;
-            exit(-1);
+            mappedSize = status.st_size;
+            mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                close(fd);
+                throw SourceError("*** ERROR: Failed to read "
+                                  + sourceFileName);
+            }
+
+            // The scanner reads straight through the file.
+            madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+
+            start = static_cast<const char *>(mapping);
+            next  = start;
+            end   = start + mappedSize;
         }
 
+        close(fd);
         currentCh = nextChar();  // read the first character of the file
     }
 
+    /**
+     * Constructor for source text that's already in memory.
+     * @param text the source text.
+     * @param name a name for the source in messages.
+     * @param firstLine the line number of the text's first line, e.g.
+     *                  if the text is an excerpt from a larger source.
+     */
+    Source(string_view text, string name, int firstLine = 1)
+        : sourceFileName(name), constants(&ConstantPool::global()),
+          text(text), mapping(nullptr), mappedSize(0),
+          lineNum(firstLine)
+    {
+        start = this->text.data();
+        next  = start;
+        end   = start + this->text.size();
+
+        currentCh = nextChar();  // read the first character of the text
+    }
+
+    Source(const Source &) = delete;
+    Source &operator =(const Source &) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~Source()
+    {
+        if (mapping != nullptr) munmap(mapping, mappedSize);
+    }
+
+    /**
+     * Getter.
+     * @return the source's name, e.g. its file name.
+     */
+    const string &getName() const { return sourceFileName; }
+
     /**
      * Getter.
      * @return the current source line number.
      */
     int lineNumber() const { return lineNum; }
 
+    /**
+     * Getter.
+     * @return the pool to intern the source's string literals in.
+     */
+    ConstantPool *getConstantPool() const { return constants; }
+
+    /**
+     * Setter.
+     * @param pool a pool to intern the string literals in instead of
+     *             the global pool, which must outlive their uses.
+     */
+    void setConstantPool(ConstantPool *pool) { constants = pool; }
+
+    /**
+     * Getter.
+     * @return the whole source text.
+     */
+    string_view getText() const { return string_view(start, end - start); }
+
+    /**
+     * Getter.
+     * @return the offset of the current character in the source text,
+     *         or the length of the text if at the end.
+     */
+    size_t position() const
+    {
+        return (next - start) - (currentCh == EOF ? 0 : 1);
+    }
+
     /**
      * Getter.
      * @return the current source character.
@@ -62,15 +206,11 @@ public:
      */
     char nextChar()
     {
-        currentCh = source.get();
-
-        if (source.eof()) currentCh = EOF;
-        else if (currentCh == EOL) lineNum++;
-
-        else if (source.fail())
+        if (next == end) currentCh = EOF;
+        else
         {
-            cout << "*** ERROR: Failed to read " << sourceFileName << endl;
-            exit(-1);
+            currentCh = *next++;
+            if (currentCh == EOL) lineNum++;
         }
 
         return currentCh;
@@ -6,48 +6,29 @@
  * San Jose State University
  */
 #include <string>
-#include <map>
+#include <stdexcept>
 #include <ctype.h>
 
 #include "../Object.h"
+#include "../Output.h"
 #include "Token.h"
 
 namespace frontend {
 
 using namespace std;
 
-map<string, TokenType> Token::reservedWords;
-
-void Token::initialize()
+TokenType Token::reservedWordType(string_view word)
 {
-    reservedWords["PROGRAM"]   = PROGRAM;
-    reservedWords["BEGIN"]     = BEGIN;
-    reservedWords["END"]       = END;
-    reservedWords["REPEAT"]    = REPEAT;
-    reservedWords["UNTIL"]     = UNTIL;
-    reservedWords["WRITE"]     = WRITE;
-    reservedWords["WRITELN"]   = WRITELN;
-    reservedWords["DIV"]       = DIV;
-    reservedWords["MOD"]       = MOD;
-    reservedWords["AND"]       = AND;
-    reservedWords["OR"]        = OR;
-    reservedWords["NOT"]       = NOT;
-    reservedWords["CONST"]     = CONST;
-    reservedWords["TYPE"]      = TYPE;
-    reservedWords["VAR"]       = VAR;
-    reservedWords["PROCEDURE"] = PROCEDURE;
-    reservedWords["FUNCTION"]  = FUNCTION;
-    reservedWords["WHILE"]     = WHILE;
-    reservedWords["DO"]        = DO;
-    reservedWords["FOR"]       = FOR;
-    reservedWords["TO"]        = TO;
-    reservedWords["DOWNTO"]    = DOWNTO;
-    reservedWords["IF"]        = IF;
-    reservedWords["THEN"]      = THEN;
-    reservedWords["ELSE"]      = ELSE;
-    reservedWords["WHILE"]     = WHILE;
-    reservedWords["CASE"]      = CASE;
-    reservedWords["OF"]        = OF;
+    for (const ReservedWord &reserved : reservedWords)
+    {
+        if (reserved.name.size() != word.size()) continue;
+
+        size_t i = 0;
+        while ((i < word.size()) && (toupper(word[i]) == reserved.name[i])) i++;
+        if (i == word.size()) return reserved.type;
+    }
+
+    return TokenType::IDENTIFIER;
 }
 
 Token *Token::Word(char firstChar, Source *source)
@@ -63,15 +44,7 @@ Token *Token::Word(char firstChar, Source *source)
     }
 
     // Is it a reserved word or an identifier?
-    string upper = toUpperCase(token->text);
-    if (Token::reservedWords.find(upper) != Token::reservedWords.end())
-    {
-        token->type = Token::reservedWords[upper];
-    }
-    else
-    {
-        token->type = TokenType::IDENTIFIER;
-    }
+    token->type = reservedWordType(token->text);
 
     return token;
 }
@@ -95,16 +68,31 @@ Token *Token::Number(char firstChar, Source *source)
     // Integer constant.
     if (pointCount == 0)
     {
-        token->type    = TokenType::INTEGER;
-        token->value.L = stol(token->text);
-        token->value.D = token->value.L;  // allow using integer value as double
+        try
+        {
+            token->type  = TokenType::INTEGER;
+            token->value = Object(stol(token->text));  // also readable as double
+        }
+        catch (const out_of_range &)
+        {
+            token->type = TokenType::ERROR;
+            tokenError(token, "Integer out of range");
+        }
     }
 
     // Real constant.
     else if (pointCount == 1)
     {
-        token->type    = TokenType::REAL;
-        token->value.D = stod(token->text);
+        try
+        {
+            token->type  = TokenType::REAL;
+            token->value = Object(stod(token->text));
+        }
+        catch (const out_of_range &)
+        {
+            token->type = TokenType::ERROR;
+            tokenError(token, "Real out of range");
+        }
     }
 
     else
@@ -170,7 +158,8 @@ Token *Token::CharacterOrString(char firstChar, Source *source)
     token->type = length == 1 ? TokenType::CHARACTER : TokenType::STRING;
 
     // Don't include the leading and trailing '.
-    token->value.S = token->text.substr(1, token->text.length() - 2);
+    token->value = Object(source->getConstantPool()->intern(
+                              token->text.substr(1, token->text.length() - 2)));
 
     return token;
 }
@@ -301,8 +290,8 @@ Token *Token::SpecialSymbol(char firstChar, Source *source)
 
 void Token::tokenError(Token *token, string message)
 {
-    printf("TOKEN ERROR at line %d: %s at '%s'\n",
-           token->lineNumber, message.c_str(), token->text.c_str());
+    output().print("TOKEN ERROR at line %d: %s at '%s'\n",
+                   token->lineNumber, message.c_str(), token->text.c_str());
 }
 
 }  // namespace frontend
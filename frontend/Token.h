@@ -9,7 +9,7 @@
 #define TOKEN_H_
 
 #include <string>
-#include <map>
+#include <string_view>
 
 #include "../Object.h"
 #include "Source.h"
@@ -33,7 +33,7 @@ enum class TokenType
     END_OF_FILE, ERROR
 };
 
-static const string TOKEN_TYPE_STRINGS[] =
+constexpr const char *TOKEN_TYPE_STRINGS[] =
 {
     "PROGRAM", "BEGIN", "END", "REPEAT", "UNTIL", "WRITE", "WRITELN",
     "DIV", "MOD", "AND", "OR", "NOT",
@@ -108,16 +108,53 @@ constexpr TokenType ERROR          = TokenType::ERROR;
 class Token
 {
 private:
+    struct ReservedWord
+    {
+        string_view name;
+        TokenType type;
+    };
+
     /**
-     * The table (as a map) of reserved words. Initialize the table.
+     * The table of reserved words. It's built at compile time.
      */
-    static map<string, TokenType> reservedWords;
+    static constexpr ReservedWord reservedWords[] =
+    {
+        { "PROGRAM",   TokenType::PROGRAM   },
+        { "BEGIN",     TokenType::BEGIN     },
+        { "END",       TokenType::END       },
+        { "REPEAT",    TokenType::REPEAT    },
+        { "UNTIL",     TokenType::UNTIL     },
+        { "WRITE",     TokenType::WRITE     },
+        { "WRITELN",   TokenType::WRITELN   },
+        { "DIV",       TokenType::DIV       },
+        { "MOD",       TokenType::MOD       },
+        { "AND",       TokenType::AND       },
+        { "OR",        TokenType::OR        },
+        { "NOT",       TokenType::NOT       },
+        { "CONST",     TokenType::CONST     },
+        { "TYPE",      TokenType::TYPE      },
+        { "VAR",       TokenType::VAR       },
+        { "PROCEDURE", TokenType::PROCEDURE },
+        { "FUNCTION",  TokenType::FUNCTION  },
+        { "WHILE",     TokenType::WHILE     },
+        { "DO",        TokenType::DO        },
+        { "FOR",       TokenType::FOR       },
+        { "TO",        TokenType::TO        },
+        { "DOWNTO",    TokenType::DOWNTO    },
+        { "IF",        TokenType::IF        },
+        { "THEN",      TokenType::THEN      },
+        { "ELSE",      TokenType::ELSE      },
+        { "CASE",      TokenType::CASE      },
+        { "OF",        TokenType::OF        },
+    };
 
 public:
     /**
-     * Initialize the static map.
+     * Look up a word in the reserved word table, ignoring case.
+     * @param word the word.
+     * @return its reserved word type, or IDENTIFIER if it isn't reserved.
      */
-    static void initialize();
+    static TokenType reservedWordType(string_view word);
 
     TokenType type;  // what type of token
     int lineNumber;  // source line number of the token
@@ -0,0 +1,243 @@
+/**
+ * Flat parse tree format for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <string.h>
+
+#include "../Hash.h"
+#include "../Object.h"
+#include "FlatTree.h"
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * Append a string to the string area.
+ * @param strings the string area.
+ * @param str the string.
+ * @return its offset.
+ */
+static uint32_t addString(string *strings, string_view str)
+{
+    uint32_t offset = strings->size();
+    strings->append(str);
+
+    return offset;
+}
+
+string FlatTree::flatten(Node *root, const vector<string> &slotNames,
+                         string_view source, uint64_t sourceHash)
+{
+    vector<Node *> order(1, root);  // the nodes in flat order
+    vector<FlatNode> nodes;
+    string strings;
+
+    // Lay the tree out breadth first, so that each
+    // node's children are consecutive.
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        Node *node = order[i];
+        FlatNode flat;
+        memset(&flat, 0, sizeof(flat));
+
+        flat.type       = (uint8_t) node->type;
+        flat.valueType  = (uint8_t) node->value.getType();
+        flat.lineNumber = node->lineNumber;
+        flat.slot       = node->slot;
+        flat.firstChild = order.size();
+        flat.childCount = node->children.size();
+        flat.textLength = node->text.size();
+        flat.textOffset = addString(&strings, node->text);
+
+        switch (node->value.getType())
+        {
+            case Object::Type::LONG   : flat.value.l = node->value.L(); break;
+            case Object::Type::DOUBLE : flat.value.d = node->value.D(); break;
+            case Object::Type::BOOL   : flat.value.b = node->value.B(); break;
+
+            case Object::Type::STRING :
+            {
+                string_view value = node->value.S();
+                flat.value.s.length = value.size();
+                flat.value.s.offset = addString(&strings, value);
+                break;
+            }
+
+            default : break;
+        }
+
+        nodes.push_back(flat);
+        for (Node *child : node->children) order.push_back(child);
+    }
+
+    vector<uint32_t> slots;
+    for (const string &name : slotNames)
+    {
+        slots.push_back(addString(&strings, name));
+        slots.push_back(name.size());
+    }
+
+    FlatHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FLAT_MAGIC, sizeof(header.magic));
+    header.version       = FLAT_VERSION;
+    header.nodeCount     = nodes.size();
+    header.slotCount     = slotNames.size();
+    header.stringsSize   = strings.size();
+    header.nodesOffset   = sizeof(FlatHeader);
+    header.slotsOffset   = header.nodesOffset + nodes.size()*sizeof(FlatNode);
+    header.stringsOffset = header.slotsOffset + slots.size()*sizeof(uint32_t);
+    header.sourceLength  = source.size();
+    header.sourceHash    = sourceHash;
+
+    string image;
+    image.reserve(header.stringsOffset + strings.size());
+    image.append((const char *) &header, sizeof(header));
+    image.append((const char *) nodes.data(), nodes.size()*sizeof(FlatNode));
+    image.append((const char *) slots.data(), slots.size()*sizeof(uint32_t));
+    image.append(strings);
+
+    // Checksum everything after the header.
+    header.checksum = hash64(string_view(image).substr(sizeof(header)));
+    memcpy(&image[0], &header, sizeof(header));
+
+    return image;
+}
+
+FlatTree::FlatTree(string_view image)
+    : header(nullptr), nodes(nullptr), slots(nullptr), strings(nullptr)
+{
+    const FlatHeader *h = (const FlatHeader *) image.data();
+    uint64_t size = image.size();
+
+    // Check that the sections the header describes are within the
+    // image, in order, and aligned. The offsets are checked against
+    // the size first so that adding to them can't overflow.
+    if (   (size < sizeof(FlatHeader))
+        || (memcmp(h->magic, FLAT_MAGIC, sizeof(h->magic)) != 0)
+        || (h->version != FLAT_VERSION)
+        || (h->nodeCount == 0)
+        || (h->nodesOffset < sizeof(FlatHeader))
+        || (h->nodesOffset%alignof(FlatNode) != 0)
+        || (h->slotsOffset%alignof(uint32_t) != 0)
+        || (h->nodesOffset > size)
+        || (h->slotsOffset > size)
+        || (h->stringsOffset > size)
+        || (h->nodesOffset + (uint64_t) h->nodeCount*sizeof(FlatNode)
+                > h->slotsOffset)
+        || (h->slotsOffset + (uint64_t) h->slotCount*2*sizeof(uint32_t)
+                > h->stringsOffset)
+        || (h->stringsOffset + h->stringsSize != size)
+        || (hash64(image.substr(sizeof(FlatHeader))) != h->checksum))
+    {
+        return;
+    }
+
+    header  = h;
+    nodes   = (const FlatNode *) (image.data() + h->nodesOffset);
+    slots   = (const uint32_t *) (image.data() + h->slotsOffset);
+    strings = image.data() + h->stringsOffset;
+
+    if (!verifyContents()) header = nullptr;
+}
+
+/**
+ * @param offset the offset of a string.
+ * @param length its length.
+ * @param stringsSize the size of the string area.
+ * @return true if the string is within the string area.
+ */
+static bool isWithin(uint64_t offset, uint64_t length, uint64_t stringsSize)
+{
+    return (offset <= stringsSize) && (length <= stringsSize - offset);
+}
+
+bool FlatTree::verifyContents() const
+{
+    uint32_t nodeCount = header->nodeCount;
+    uint32_t stringsSize = header->stringsSize;
+    int32_t slotCount = header->slotCount;
+
+    for (uint32_t i = 0; i < header->slotCount; i++)
+    {
+        if (!isWithin(slots[2*i], slots[2*i + 1], stringsSize)) return false;
+    }
+
+    // The root is the program.
+    if ((NodeType) nodes[0].type != PROGRAM) return false;
+
+    for (uint32_t i = 0; i < nodeCount; i++)
+    {
+        const FlatNode &node = nodes[i];
+
+        if (node.type > (uint8_t) NodeType::NOT) return false;
+        if (node.valueType > (uint8_t) Object::Type::BOOL) return false;
+
+        // Children come after their parent, so the tree has no cycles.
+        if (   (node.childCount > 0)
+            && (   (node.firstChild <= i)
+                || (node.childCount > nodeCount - node.firstChild)))
+        {
+            return false;
+        }
+
+        if (!isWithin(node.textOffset, node.textLength, stringsSize))
+        {
+            return false;
+        }
+
+        if (   (node.valueType == (uint8_t) Object::Type::STRING)
+            && !isWithin(node.value.s.offset, node.value.s.length,
+                         stringsSize))
+        {
+            return false;
+        }
+
+        // The executors index a frame by a variable's slot
+        // and reach for the children that each type must have.
+        uint32_t required;
+        switch ((NodeType) node.type)
+        {
+            case VARIABLE :
+                if ((node.slot < 0) || (node.slot >= slotCount)) return false;
+                required = 0;
+                break;
+
+            case PROGRAM :
+            case TEST :
+            case WRITE :
+            case NOT :
+                required = 1;
+                break;
+
+            case ASSIGN :
+            case ADD : case SUBTRACT : case MULTIPLY : case DIVIDE :
+            case EQ : case LT : case LE : case GT : case GE : case NE :
+                required = 2;
+                break;
+
+            default :
+                required = 0;
+                break;
+        }
+
+        if (node.childCount < required) return false;
+
+        // An assignment stores into its first child's slot.
+        if (   ((NodeType) node.type == ASSIGN)
+            && ((NodeType) nodes[node.firstChild].type != VARIABLE))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace intermediate
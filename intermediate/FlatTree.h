@@ -0,0 +1,163 @@
+/**
+ * Flat parse tree format for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef FLATTREE_H_
+#define FLATTREE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+#include "Node.h"
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * A parse tree node in the flat format. Its children are consecutive
+ * entries of the node array, and its strings are in the string area,
+ * so the node refers to both by index and offset instead of pointer.
+ */
+struct FlatNode
+{
+    uint8_t  type;        // the NodeType
+    uint8_t  valueType;   // the Object::Type of the value
+    uint16_t unused;
+    int32_t  lineNumber;
+    int32_t  slot;        // variable's frame slot index
+    uint32_t firstChild;  // the index of the first child
+    uint32_t childCount;
+    uint32_t textOffset;  // the node's text in the string area
+    uint32_t textLength;
+    uint32_t unused2;
+    union
+    {
+        int64_t  l;
+        double   d;
+        uint8_t  b;
+        struct { uint32_t offset, length; } s;  // in the string area
+    } value;
+};
+
+/**
+ * The header of a flat parse tree image.
+ */
+struct FlatHeader
+{
+    char     magic[8];      // FLAT_MAGIC
+    uint32_t version;       // FLAT_VERSION
+    uint32_t nodeCount;     // the root is node 0
+    uint32_t slotCount;     // frame slots, one name each
+    uint32_t stringsSize;
+    uint64_t nodesOffset;   // offsets from the start of the image
+    uint64_t slotsOffset;   // {offset, length} pairs into the strings
+    uint64_t stringsOffset;
+    uint64_t sourceLength;  // identify the source it was compiled from
+    uint64_t sourceHash;
+    uint64_t checksum;      // hash of everything after the header
+};
+
+/**
+ * A parse tree and its frame slot names laid out in one block of
+ * memory with offsets instead of pointers. It can be written to a
+ * file and later memory-mapped and executed in place, without any
+ * deserialization. Viewing an image checks all of it, so every page
+ * is read once up front rather than as execution reaches it.
+ */
+class FlatTree
+{
+public:
+    static constexpr char FLAT_MAGIC[8] = { 'S', 'I', 'M', 'P', 'L', 'E',
+                                            'A', 'T' };
+    static const uint32_t FLAT_VERSION = 2;
+
+    /**
+     * Lay out a parse tree in the flat format.
+     * @param root the root of the tree.
+     * @param slotNames the variables' names indexed by slot.
+     * @param source the source the tree was compiled from.
+     * @param sourceHash a hash of the source, to store for checking.
+     * @return the image.
+     */
+    static string flatten(Node *root, const vector<string> &slotNames,
+                          string_view source, uint64_t sourceHash);
+
+    /**
+     * Constructor. View an image, which must stay in memory.
+     * The image is checked thoroughly enough that executing a
+     * valid one can't reach outside it or the execution frame.
+     * @param image the image.
+     */
+    FlatTree(string_view image);
+
+    /**
+     * @return true if the image is a well-formed flat tree.
+     */
+    bool isValid() const { return header != nullptr; }
+
+    /**
+     * Check that the image was made from the given source.
+     * @param source the source.
+     * @param sourceHash its hash.
+     * @return true if so.
+     */
+    bool isFrom(string_view source, uint64_t sourceHash) const
+    {
+        return    (header->sourceLength == source.size())
+               && (header->sourceHash == sourceHash);
+    }
+
+    const FlatNode *getRoot() const { return nodes; }
+    int getSlotCount() const { return header->slotCount; }
+
+    /**
+     * @param node a node.
+     * @param i a child index.
+     * @return the node's i-th child.
+     */
+    const FlatNode *child(const FlatNode *node, uint32_t i) const
+    {
+        return &nodes[node->firstChild + i];
+    }
+
+    string_view text(const FlatNode *node) const
+    {
+        return string_view(strings + node->textOffset, node->textLength);
+    }
+
+    string_view stringValue(const FlatNode *node) const
+    {
+        return string_view(strings + node->value.s.offset,
+                           node->value.s.length);
+    }
+
+    string_view slotName(int slot) const
+    {
+        return string_view(strings + slots[2*slot], slots[2*slot + 1]);
+    }
+
+private:
+    const FlatHeader *header;  // null if the image isn't valid
+    const FlatNode *nodes;
+    const uint32_t *slots;
+    const char *strings;
+
+    /**
+     * Verify every slot name and node: that each string is within the
+     * string area, each child index is within the node array and after
+     * its parent, each variable's slot is within the frame, and each
+     * node has the children that its type needs.
+     * @return true if the contents are valid.
+     */
+    bool verifyContents() const;
+};
+
+}  // namespace intermediate
+
+#endif /* FLATTREE_H_ */
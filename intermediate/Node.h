@@ -12,7 +12,6 @@
 #include <vector>
 
 #include "../Object.h"
-#include "SymtabEntry.h"
 
 namespace intermediate {
 
@@ -25,7 +24,7 @@ enum class NodeType
     VARIABLE, INTEGER_CONSTANT, REAL_CONSTANT, STRING_CONSTANT, NOT
 };
 
-static const string NODE_TYPE_STRINGS[] =
+constexpr const char *NODE_TYPE_STRINGS[] =
 {
     "PROGRAM", "COMPOUND", "ASSIGN", "LOOP", "TEST", "WRITE", "WRITELN",
     "ADD", "SUBTRACT", "MULTIPLY", "DIVIDE", "EQ", "LT", "LE", "GT", "GE", "NE",
@@ -61,7 +60,8 @@ public:
     NodeType type;
     int lineNumber;
     string text;
-    SymtabEntry *entry;
+    int slot;  // variable's frame slot index
+    int sharers;  // owners of a hash-consed leaf, or 0 if it isn't one
     Object value;
     vector<Node *> children;
 
@@ -70,7 +70,24 @@ public:
      * @param type node type.
      */
     Node(NodeType type)
-        : type(type), lineNumber(0), entry(nullptr) {}
+        : type(type), lineNumber(0), slot(-1), sharers(0) {}
+
+    /**
+     * Destructor. A node owns its subtree,
+     * except for the hash-consed leaves it shares with other owners.
+     */
+    ~Node() { for (Node *child : children) release(child); }
+
+    /**
+     * Give up one owner's claim to a node, and delete the node
+     * if it was the last owner.
+     * @param node the node.
+     */
+    static void release(Node *node)
+    {
+        if ((node != nullptr) && (node->sharers > 1)) node->sharers--;
+        else                                          delete node;
+    }
 
     /**
      * Adopt a child node.
@@ -14,24 +14,49 @@ namespace intermediate {
 
 using namespace std;
 
-const string ParseTreePrinter::INDENT_SIZE = "    ";
+void ParseTreePrinter::visitProgram(Node *node)
+{
+    printNode(node, " " + node->text);
+}
+
+void ParseTreePrinter::visitVariable(Node *node)
+{
+    printNode(node, " " + node->text);
+}
+
+void ParseTreePrinter::visitIntegerConstant(Node *node)
+{
+    printNode(node, " " + to_string(node->value.L()));
+}
+
+void ParseTreePrinter::visitRealConstant(Node *node)
+{
+    printNode(node, " " + to_string(node->value.D()));
+}
+
+void ParseTreePrinter::visitStringConstant(Node *node)
+{
+    printNode(node, " '" + string(node->value.S()) + "'");
+}
 
-void ParseTreePrinter::print(Node *node)
+void ParseTreePrinter::visitDefault(Node *node)
+{
+    printNode(node, "");
+}
+
+void ParseTreePrinter::printNode(Node *node, const string &attributes)
 {
     // Opening tag.
     line += indentation;
-    line += "<" + NODE_TYPE_STRINGS[(int) node->type];
+    line += "<";
+    line += NODE_TYPE_STRINGS[(int) node->type];
 
     // Attributes.
-    if      (node->type == PROGRAM)          line += " " + node->text;
-    else if (node->type == VARIABLE)         line += " " + node->text;
-    else if (node->type == INTEGER_CONSTANT) line += " " + to_string(node->value.L);
-    else if (node->type == REAL_CONSTANT)    line += " " + to_string(node->value.D);
-    else if (node->type == STRING_CONSTANT)  line += " '" + node->value.S + "'";
-    if (node->lineNumber > 0)                line += " line " + to_string(node->lineNumber);
+    line += attributes;
+    if (node->lineNumber > 0) line += " line " + to_string(node->lineNumber);
 
     // Print the node's children followed by the closing tag.
-    vector<Node *> children = node->children;
+    const vector<Node *> &children = node->children;
     if (children.size() > 0)
     {
         line += ">";
@@ -39,7 +64,9 @@ void ParseTreePrinter::print(Node *node)
 
         printChildren(children);
         line += indentation;
-        line += "</" + NODE_TYPE_STRINGS[(int) node->type] + ">";
+        line += "</";
+        line += NODE_TYPE_STRINGS[(int) node->type];
+        line += ">";
     }
 
     // No children: Close off the tag.
@@ -48,11 +75,11 @@ void ParseTreePrinter::print(Node *node)
     printLine();
 }
 
-void ParseTreePrinter::printChildren(vector<Node *> children)
+void ParseTreePrinter::printChildren(const vector<Node *> &children)
 {
     string saveIndentation = indentation;
     indentation += INDENT_SIZE;
-    for (Node *child : children) print(child);
+    for (Node *child : children) visit(child);
     indentation = saveIndentation;
 }
 
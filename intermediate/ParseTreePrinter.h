@@ -12,15 +12,18 @@
 #include <vector>
 
 #include "Node.h"
+#include "TreeVisitor.h"
 
 namespace intermediate {
 
 using namespace std;
 
-class ParseTreePrinter
+class ParseTreePrinter : public TreeVisitor<ParseTreePrinter, void>
 {
+    friend class TreeVisitor<ParseTreePrinter, void>;
+
 private:
-    static const string INDENT_SIZE;
+    static constexpr const char *INDENT_SIZE = "    ";
 
     string indentation;  // indentation of a line
     string line;         // output line
@@ -32,14 +35,28 @@ public:
      * Print a parse tree.
      * @param node the parse tree's root node.
      */
-    void print(Node *node);
+    void print(Node *node) { visit(node); }
 
 private:
+    void visitProgram(Node *node);
+    void visitVariable(Node *node);
+    void visitIntegerConstant(Node *node);
+    void visitRealConstant(Node *node);
+    void visitStringConstant(Node *node);
+    void visitDefault(Node *node);
+
+    /**
+     * Print a parse tree node and its subtree.
+     * @param node the node.
+     * @param attributes the node's attributes, if any.
+     */
+    void printNode(Node *node, const string &attributes);
+
     /**
      * Print a parse tree node's child nodes.
      * @param children the array list of child nodes.
      */
-    void printChildren(vector<Node *> children);
+    void printChildren(const vector<Node *> &children);
 
     /**
      * Print an output line.
@@ -9,7 +9,10 @@
 #define SYMTAB_H_
 
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
 
 #include "SymtabEntry.h"
 
@@ -17,33 +20,310 @@ namespace intermediate {
 
 using namespace std;
 
+/**
+ * An open-addressing hash table of symbol table entries.
+ * Names are case-insensitive. The entries themselves are stored
+ * by value in one array, and the probe table holds each entry's
+ * hash and index into that array, so a lookup is a single linear
+ * probe sequence with no pointer chasing and no key copies.
+ *
+ * The table is also a stack of nested scopes, e.g. for procedures
+ * and functions. There is only one probe table: a declaration in an
+ * inner scope takes over the bucket of any outer entry with the same
+ * name and records the entry it shadowed in an undo log. Leaving the
+ * scope replays its part of the log backwards. Lookups are therefore
+ * O(1) at any nesting depth, and entering and leaving a scope costs
+ * time proportional to the number of names it declared.
+ */
 class Symtab
 {
 private:
-    map<string, SymtabEntry *> contents;
+    struct Bucket
+    {
+        uint32_t hash;   // case-folded hash of the entry's name
+        int32_t  index;  // index into entries, or EMPTY
+    };
+
+    struct Undo
+    {
+        uint32_t hash;      // hash of the declared name
+        int32_t  index;     // the entry that was declared
+        int32_t  shadowed;  // the entry it hid, or EMPTY
+    };
+
+    static const int32_t EMPTY     = -1;
+    static const int32_t TOMBSTONE = -2;  // a bucket vacated by leaveScope()
+    static const size_t  INITIAL_CAPACITY = 64;  // must be a power of 2
+
+    vector<SymtabEntry> entries;  // every entry in the order entered
+    vector<Bucket> buckets;       // the probe table
+    size_t mask;                  // buckets.size() - 1
+    size_t used;                  // buckets that aren't EMPTY
+    vector<Undo> undoLog;         // declarations in the nested scopes
+    vector<size_t> scopeMarks;    // undo log size when each scope began
 
 public:
+    Symtab() : buckets(INITIAL_CAPACITY, Bucket{0, EMPTY}),
+               mask(INITIAL_CAPACITY - 1), used(0) {}
+
     /**
-     * Make an entry.
+     * Make an entry in the current scope and give it the next free
+     * frame slot. It hides any entry of the same name in an outer scope.
+     * The returned pointer stays valid only until the next call.
      * @param name the entry's name.
+     * @return the new entry.
+     */
+    SymtabEntry *enter(string_view name)
+    {
+        // Keep the load factor at or below 1/2.
+        if (2*(used + 1) > buckets.size()) grow();
+
+        uint32_t hash = hashOf(name);
+        int32_t index = entries.size();
+        int level = getNestingLevel();
+        entries.push_back(SymtabEntry(string(name), index, level));
+
+        // Take over the bucket of an existing entry with the same name.
+        Bucket *bucket = probe(name, hash);
+        if (bucket->index == EMPTY) used++;
+
+        // Remember what to restore when leaving this scope.
+        if (level > 0) undoLog.push_back(Undo{hash, index, bucket->index});
+
+        bucket->hash  = hash;
+        bucket->index = index;
+
+        return &entries[index];
+    }
+
+    /**
+     * Begin a new innermost scope.
+     */
+    void enterScope() { scopeMarks.push_back(undoLog.size()); }
+
+    /**
+     * End the innermost scope. Its names become invisible and
+     * the outer entries they hid become visible again. The entries
+     * themselves, and their frame slots, remain for diagnostics.
      */
-    SymtabEntry *enter(string name)
+    void leaveScope()
     {
-        SymtabEntry *entry = new SymtabEntry(name);
-        contents[name] = entry;
+        size_t mark = scopeMarks.back();
+        scopeMarks.pop_back();
 
-        return entry;
+        while (undoLog.size() > mark)
+        {
+            Undo &undo = undoLog.back();
+            Bucket *bucket = probe(entries[undo.index].getName(), undo.hash);
+            bucket->index = undo.shadowed != EMPTY ? undo.shadowed
+                                                   : TOMBSTONE;
+            undoLog.pop_back();
+        }
     }
 
+    /**
+     * Remove the entries made since the table had a given size, e.g.
+     * the variables of an input that failed. Their frame slots are
+     * freed for the next entries. Only for the global scope, where
+     * no entry shadows another.
+     * @param count the number of entries to keep.
+     */
+    void truncate(int count)
+    {
+        if (count >= (int) entries.size()) return;
+
+        for (Bucket &bucket : buckets)
+        {
+            if (bucket.index >= count) bucket.index = TOMBSTONE;
+        }
+
+        entries.erase(entries.begin() + count, entries.end());
+    }
+
+    /**
+     * Getter.
+     * @return the nesting level of the current scope, 0 for global.
+     */
+    int getNestingLevel() const { return scopeMarks.size(); }
+
     /**
      * Look up an entry.
-     * @param name the entry's name.
+     * The returned pointer stays valid only until the next enter().
+     * @param name the entry's name, in any case.
      * @return the entry or null if it's not in the symbol table.
      */
-    SymtabEntry *lookup(string name)
+    SymtabEntry *lookup(string_view name)
+    {
+        Bucket *bucket = probe(name, hashOf(name));
+        return bucket->index >= 0 ? &entries[bucket->index] : nullptr;
+    }
+
+    const SymtabEntry *lookup(string_view name) const
     {
-        return contents.find(name) != contents.end() ? contents[name]
-                                                     : nullptr;
+        return const_cast<Symtab *>(this)->lookup(name);
+    }
+
+    /**
+     * Look up an entry in the current scope only.
+     * @param name the entry's name, in any case.
+     * @return the entry or null if the current scope didn't declare it.
+     */
+    SymtabEntry *lookupLocal(string_view name)
+    {
+        SymtabEntry *entry = lookup(name);
+        return (entry != nullptr) && (entry->getLevel() == getNestingLevel())
+                    ? entry : nullptr;
+    }
+
+    /**
+     * Getter.
+     * @return the number of frame slots an execution context needs.
+     */
+    int size() const { return entries.size(); }
+
+    /**
+     * @return the entries' names indexed by their frame slots.
+     */
+    vector<string> getSlotNames() const
+    {
+        vector<string> names(entries.size());
+        for (const SymtabEntry &entry : entries)
+        {
+            names[entry.getSlot()] = entry.getName();
+        }
+
+        return names;
+    }
+
+    /**
+     * Renumber the frame slots so that the most heavily accessed
+     * entries come first and therefore share cache lines at run time.
+     * Entries with equal weights keep their relative order.
+     * @return a table that maps each old slot index to its new one.
+     */
+    vector<int> assignSlotsByFrequency()
+    {
+        vector<SymtabEntry *> ordered;
+        for (SymtabEntry &entry : entries) ordered.push_back(&entry);
+
+        stable_sort(ordered.begin(), ordered.end(),
+                    [](SymtabEntry *a, SymtabEntry *b)
+                    {
+                        return a->getAccessWeight() > b->getAccessWeight();
+                    });
+
+        vector<int> remap(entries.size());
+        for (int slot = 0; slot < (int) ordered.size(); slot++)
+        {
+            remap[ordered[slot]->getSlot()] = slot;
+            ordered[slot]->setSlot(slot);
+        }
+
+        return remap;
+    }
+
+private:
+    /**
+     * Fold an identifier character to lower case. Identifiers are
+     * ASCII letters and digits, so this avoids the locale lookup
+     * that tolower() does for every character.
+     * @param ch the character.
+     * @return the folded character.
+     */
+    static char fold(char ch)
+    {
+        return ((ch >= 'A') && (ch <= 'Z')) ? ch + ('a' - 'A') : ch;
+    }
+
+    /**
+     * Compute the FNV-1a hash of a name with its letters folded to
+     * lower case, so that differently cased spellings collide.
+     * @param name the name.
+     * @return the hash value.
+     */
+    static uint32_t hashOf(string_view name)
+    {
+        uint32_t hash = 2166136261u;
+        for (char ch : name)
+        {
+            hash ^= (unsigned char) fold(ch);
+            hash *= 16777619u;
+        }
+
+        // Mix the high bits into the low ones that pick the bucket.
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+
+        return hash;
+    }
+
+    /**
+     * Compare two names without regard to case.
+     * @return true if they're the same name.
+     */
+    static bool sameName(string_view a, string_view b)
+    {
+        if (a.size() != b.size()) return false;
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (fold(a[i]) != fold(b[i])) return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Find the bucket that holds a name, or else the empty bucket
+     * where the name would be inserted. Tombstones don't end the
+     * probe sequence since a name may have been inserted past them.
+     * @param name the name.
+     * @param hash the name's hash.
+     * @return the bucket.
+     */
+    Bucket *probe(string_view name, uint32_t hash)
+    {
+        for (size_t i = hash & mask; ; i = (i + 1) & mask)
+        {
+            Bucket *bucket = &buckets[i];
+
+            if (bucket->index == EMPTY) return bucket;
+            if (   (bucket->index != TOMBSTONE)
+                && (bucket->hash == hash)
+                && sameName(entries[bucket->index].getName(), name))
+            {
+                return bucket;
+            }
+        }
+    }
+
+    /**
+     * Rebuild the probe table without its tombstones,
+     * doubling its size if it's still at least half full.
+     */
+    void grow()
+    {
+        size_t live = 0;
+        for (const Bucket &bucket : buckets) if (bucket.index >= 0) live++;
+
+        size_t capacity = buckets.size();
+        if (2*(live + 1) > capacity) capacity *= 2;
+
+        vector<Bucket> old;
+        old.swap(buckets);
+        buckets.assign(capacity, Bucket{0, EMPTY});
+        mask = capacity - 1;
+        used = live;
+
+        for (const Bucket &bucket : old)
+        {
+            if (bucket.index < 0) continue;
+
+            size_t i = bucket.hash & mask;
+            while (buckets[i].index != EMPTY) i = (i + 1) & mask;
+            buckets[i] = bucket;
+        }
     }
 };
 
@@ -18,32 +18,55 @@ class SymtabEntry
 {
 private:
     string name;
-    double value;
+    int slot;            // index of the entry's value in an execution frame
+    int level;           // nesting level of the scope that declared it
+    long accessWeight;   // static access count, weighted by loop nesting
 
 public:
     /**
      * Constructor.
      * @param name the entry's name.
+     * @param slot the entry's frame slot index.
+     * @param level the nesting level of the entry's scope.
      */
-    SymtabEntry(string name) : name(name), value(0.0) {}
+    SymtabEntry(string name, int slot, int level = 0)
+        : name(name), slot(slot), level(level), accessWeight(0) {}
 
     /**
      * Getter.
      * @return the entry's name.
      */
-    string getName()  const { return name;  }
+    const string &getName() const { return name; }
 
     /**
      * Getter.
-     * @return the entry's valuel
+     * @return the entry's frame slot index.
      */
-    double getValue() const { return value; }
+    int getSlot() const { return slot; }
 
     /**
-     * Set the entry's value.
-     * @param value the value to set.
+     * Setter.
+     * @param slot the entry's new frame slot index.
      */
-    void setValue(const double value) { this->value = value; }
+    void setSlot(const int slot) { this->slot = slot; }
+
+    /**
+     * Getter.
+     * @return the nesting level of the scope that declared the entry.
+     */
+    int getLevel() const { return level; }
+
+    /**
+     * Getter.
+     * @return the entry's weighted static access count.
+     */
+    long getAccessWeight() const { return accessWeight; }
+
+    /**
+     * Record a reference to the entry in the source program.
+     * @param weight how much the reference counts, e.g. more inside loops.
+     */
+    void addAccess(const long weight) { accessWeight += weight; }
 };
 
 }  // namespace intermediate
@@ -0,0 +1,108 @@
+/**
+ * Parse tree visitor template for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef TREEVISITOR_H_
+#define TREEVISITOR_H_
+
+#include "Node.h"
+
+namespace intermediate {
+
+/**
+ * A parse tree visitor that dispatches on the node type at compile
+ * time using the curiously recurring template pattern. A visitor
+ * derives from TreeVisitor<itself, result type> and hides only the
+ * visitXxx() functions of the node types it cares about. Every call
+ * is bound statically, so there are no virtual calls and the compiler
+ * is free to inline the derived functions into visit().
+ *
+ * The visitXxx() functions that aren't hidden fall back first to
+ * visitStatement() or visitExpression() according to the node type,
+ * and then to visitDefault(), which returns a default-constructed result.
+ * A derived visitor that keeps its visitXxx() functions private must
+ * befriend its TreeVisitor base.
+ */
+template <class Derived, class Result>
+class TreeVisitor
+{
+public:
+    /**
+     * Visit a node by calling the derived visitor's function for its type.
+     * @param node the node.
+     * @return the derived function's result.
+     */
+    Result visit(Node *node)
+    {
+        Derived *d = static_cast<Derived *>(this);
+
+        switch (node->type)
+        {
+            case PROGRAM          : return d->visitProgram(node);
+            case COMPOUND         : return d->visitCompound(node);
+            case ASSIGN           : return d->visitAssign(node);
+            case LOOP             : return d->visitLoop(node);
+            case TEST             : return d->visitTest(node);
+            case WRITE            : return d->visitWrite(node);
+            case WRITELN          : return d->visitWriteln(node);
+            case ADD              : return d->visitAdd(node);
+            case SUBTRACT         : return d->visitSubtract(node);
+            case MULTIPLY         : return d->visitMultiply(node);
+            case DIVIDE           : return d->visitDivide(node);
+            case EQ               : return d->visitEq(node);
+            case LT               : return d->visitLt(node);
+            case LE               : return d->visitLe(node);
+            case GT               : return d->visitGt(node);
+            case GE               : return d->visitGe(node);
+            case NE               : return d->visitNe(node);
+            case VARIABLE         : return d->visitVariable(node);
+            case INTEGER_CONSTANT : return d->visitIntegerConstant(node);
+            case REAL_CONSTANT    : return d->visitRealConstant(node);
+            case STRING_CONSTANT  : return d->visitStringConstant(node);
+            case NOT              : return d->visitNot(node);
+        }
+
+        return d->visitDefault(node);
+    }
+
+protected:
+    Result visitProgram(Node *node)  { return derived()->visitDefault(node); }
+    Result visitTest(Node *node)     { return derived()->visitDefault(node); }
+
+    Result visitCompound(Node *node) { return derived()->visitStatement(node); }
+    Result visitAssign(Node *node)   { return derived()->visitStatement(node); }
+    Result visitLoop(Node *node)     { return derived()->visitStatement(node); }
+    Result visitWrite(Node *node)    { return derived()->visitStatement(node); }
+    Result visitWriteln(Node *node)  { return derived()->visitStatement(node); }
+
+    Result visitAdd(Node *node)      { return derived()->visitExpression(node); }
+    Result visitSubtract(Node *node) { return derived()->visitExpression(node); }
+    Result visitMultiply(Node *node) { return derived()->visitExpression(node); }
+    Result visitDivide(Node *node)   { return derived()->visitExpression(node); }
+    Result visitEq(Node *node)       { return derived()->visitExpression(node); }
+    Result visitLt(Node *node)       { return derived()->visitExpression(node); }
+    Result visitLe(Node *node)       { return derived()->visitExpression(node); }
+    Result visitGt(Node *node)       { return derived()->visitExpression(node); }
+    Result visitGe(Node *node)       { return derived()->visitExpression(node); }
+    Result visitNe(Node *node)       { return derived()->visitExpression(node); }
+    Result visitNot(Node *node)      { return derived()->visitExpression(node); }
+
+    Result visitVariable(Node *node)        { return derived()->visitExpression(node); }
+    Result visitIntegerConstant(Node *node) { return derived()->visitExpression(node); }
+    Result visitRealConstant(Node *node)    { return derived()->visitExpression(node); }
+    Result visitStringConstant(Node *node)  { return derived()->visitExpression(node); }
+
+    Result visitStatement(Node *node)  { return derived()->visitDefault(node); }
+    Result visitExpression(Node *node) { return derived()->visitDefault(node); }
+    Result visitDefault(Node *)        { return Result(); }
+
+private:
+    Derived *derived() { return static_cast<Derived *>(this); }
+};
+
+}  // namespace intermediate
+
+#endif /* TREEVISITOR_H_ */